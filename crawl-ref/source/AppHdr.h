@@ -249,6 +249,12 @@ static inline double pow(int x, double y) { return std::pow((double)x, y); }
     #define SCORE_FILE_ENTRIES 1000
     #endif
 
+    // Keep the score table in an append-only log with a small sorted
+    // index, so that a game ending only holds the scores lock long enough
+    // to append one line and rewrite the index. The classic score file is
+    // imported the first time; "crawl -scorefile" still prints xlog lines.
+    // #define SCORE_FILE_INDEXED
+
     // If defined, the hiscores code dumps preformatted verbose and terse
     // death message strings in the logfile for the convenience of logfile
     // parsers.
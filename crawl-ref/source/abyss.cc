@@ -65,9 +65,24 @@ abyss_state abyssal_state;
 
 static ProceduralLayout *abyssLayout = nullptr, *levelLayout = nullptr;
 
-typedef priority_queue<ProceduralSample, vector<ProceduralSample>, ProceduralSamplePQCompare> sample_queue;
+// A priority queue of samples which also exposes the pending samples, so that
+// the ones due for an update can be computed together.
+class sample_queue : public priority_queue<ProceduralSample,
+                                           vector<ProceduralSample>,
+                                           ProceduralSamplePQCompare>
+{
+public:
+    explicit sample_queue(const ProceduralSamplePQCompare &cmp
+                              = ProceduralSamplePQCompare())
+        : priority_queue(cmp) { }
+    const vector<ProceduralSample> &samples() const { return c; }
+};
 
 static sample_queue abyss_sample_queue;
+// Samples computed in advance for the cells an area update is about to
+// examine, and where each one is in that list (or -1).
+static vector<ProceduralSample> abyss_presamples;
+static FixedArray<int, GXM, GYM> abyss_presample_index(-1);
 static vector<dungeon_feature_type> abyssal_features;
 static list<monster*> displaced_monsters;
 
@@ -733,6 +748,7 @@ static void _abyss_wipe_square_at(coord_def p, bool saveMonsters=false)
     if (env.map_forgotten.get())
         (*env.map_forgotten.get())(p).clear();
     env.map_seen.set(p, false);
+    update_travel_region_cell(p);
     StashTrack.update_stash(p);
 }
 
@@ -1068,6 +1084,13 @@ static ProceduralSample _abyss_grid(const coord_def &p)
 {
     const coord_def pt = p + abyssal_state.major_coord;
 
+    if (in_bounds(p) && abyss_presample_index(p) >= 0)
+    {
+        const ProceduralSample sample = abyss_presamples[abyss_presample_index(p)];
+        abyss_sample_queue.push(sample);
+        return sample;
+    }
+
     if (_in_wastes(pt))
     {
         ProceduralSample sample = wastes(pt, abyssal_state.depth);
@@ -1091,6 +1114,80 @@ static ProceduralSample _abyss_grid(const coord_def &p)
     return sample;
 }
 
+/**
+ * Sample the given cells of the current area all at once, ahead of
+ * _abyss_grid() asking for them one by one. The layouts are pure functions of
+ * position and depth, so this gives the same results; it just lets them share
+ * their noise computations.
+ *
+ * @param cells  The cells (in level coordinates) which are likely to be
+ *               updated.
+ */
+static void _abyss_presample(const map_bitmask &cells)
+{
+    // [0]: cells in the wastes, [1]: everything else.
+    vector<coord_def> local[2], points[2];
+    for (rectangle_iterator ri(1); ri; ++ri)
+    {
+        if (!cells(*ri))
+            continue;
+        const coord_def pt = *ri + abyssal_state.major_coord;
+        const int which = _in_wastes(pt) ? 0 : 1;
+        local[which].push_back(*ri);
+        points[which].push_back(pt);
+    }
+
+    // The main layout picks a level with the RNG when it is first needed;
+    // leave that to _abyss_grid() so that it happens at the usual time.
+    if (!abyssLayout)
+    {
+        local[1].clear();
+        points[1].clear();
+    }
+
+    vector<ProceduralSample> samples;
+    for (int which = 0; which < 2; ++which)
+    {
+        if (points[which].empty())
+            continue;
+        if (which == 0)
+            wastes.sample(points[which], abyssal_state.depth, samples);
+        else
+            abyssLayout->sample(points[which], abyssal_state.depth, samples);
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            abyss_presample_index(local[which][i]) = abyss_presamples.size();
+            abyss_presamples.push_back(samples[i]);
+        }
+    }
+}
+
+static void _abyss_clear_presamples()
+{
+    for (const ProceduralSample &sample : abyss_presamples)
+        abyss_presample_index(sample.coord() - abyssal_state.major_coord) = -1;
+    abyss_presamples.clear();
+}
+
+/// Will _update_abyss_terrain() need a sample for this (level) position?
+static bool _abyss_wants_sample(const coord_def &rp,
+                                const map_bitmask &abyss_genlevel_mask,
+                                bool morph)
+{
+    if (!in_bounds(rp) || map_masked(rp, MMT_VAULT)
+        || !abyss_genlevel_mask(rp))
+    {
+        return false;
+    }
+    const dungeon_feature_type currfeat = grd(rp);
+    if (currfeat == DNGN_EXIT_ABYSS || currfeat == DNGN_ABYSSAL_STAIR
+        || feat_is_altar(currfeat))
+    {
+        return false;
+    }
+    return currfeat == DNGN_UNSEEN || morph;
+}
+
 static cloud_type _cloud_from_feat(const dungeon_feature_type &ft)
 {
     switch (ft)
@@ -1245,6 +1342,36 @@ static void _abyss_apply_terrain(const map_bitmask &abyss_genlevel_mask,
     int altars_wanted = 0;
     bool use_abyss_exit_map = true;
     bool used_queue = false;
+
+    // Work out which cells will certainly be examined below, and sample them
+    // together. Cells which are only updated by chance are left alone, as
+    // checking that chance here would disturb the RNG.
+    map_bitmask wanted;
+    if (morph && !abyss_sample_queue.empty())
+    {
+        for (const ProceduralSample &sample : abyss_sample_queue.samples())
+        {
+            const coord_def rp = sample.coord() - abyssal_state.major_coord;
+            if (sample.changepoint() < abyssal_state.depth
+                && _abyss_wants_sample(rp, abyss_genlevel_mask, morph))
+            {
+                wanted.set(rp);
+            }
+        }
+    }
+    else
+    {
+        for (rectangle_iterator ri(MAPGEN_BORDER); ri; ++ri)
+        {
+            if ((now || !map_masked(*ri, MMT_TURNED_TO_FLOOR))
+                && _abyss_wants_sample(*ri, abyss_genlevel_mask, morph))
+            {
+                wanted.set(*ri);
+            }
+        }
+    }
+    _abyss_presample(wanted);
+
     if (morph && !abyss_sample_queue.empty())
     {
         int ii = 0;
@@ -1304,6 +1431,7 @@ static void _abyss_apply_terrain(const map_bitmask &abyss_genlevel_mask,
     }
     if (ii)
         dprf(DIAG_ABYSS, "Nuked %d features", ii);
+    _abyss_clear_presamples();
     _ensure_player_habitable(false);
     for (rectangle_iterator ri(MAPGEN_BORDER); ri; ++ri)
         ASSERT_RANGE(grd(*ri), DNGN_UNSEEN + 1, NUM_FEATURES);
@@ -2,9 +2,130 @@
 
 #include "act-iter.h"
 
+#include "bitary.h"
+#include "coord.h"
 #include "env.h"
 #include "losglobal.h"
 
+// The env.mons slots holding a monster, in order, so iterating over a level
+// with a handful of monsters doesn't look at every slot in env.mons. Slots
+// are added when they are handed out, filled by copying or moved, and
+// dropped when their monster is reset on death.
+static vector<short> _mons_live;
+static FixedBitVector<MAX_MONSTERS> _mons_listed;
+
+// The same slots filed in a coarse grid of buckets by position, again in
+// order, so that the near iterators only look at the monsters in the few
+// buckets that LOS can reach.
+#define MONS_BUCKET_SHIFT 3
+#define MONS_BUCKETS_X ((GXM + (1 << MONS_BUCKET_SHIFT) - 1) >> MONS_BUCKET_SHIFT)
+#define MONS_BUCKETS_Y ((GYM + (1 << MONS_BUCKET_SHIFT) - 1) >> MONS_BUCKET_SHIFT)
+
+static vector<short> _mons_buckets[MONS_BUCKETS_X][MONS_BUCKETS_Y];
+static coord_def _mons_bucket_of[MAX_MONSTERS];
+
+static coord_def _mons_bucket(const coord_def &pos)
+{
+    return coord_def(min(max(pos.x, 0), GXM - 1) >> MONS_BUCKET_SHIFT,
+                     min(max(pos.y, 0), GYM - 1) >> MONS_BUCKET_SHIFT);
+}
+
+static void _slot_insert(vector<short> &slots, int i)
+{
+    slots.insert(lower_bound(slots.begin(), slots.end(), i), i);
+}
+
+static void _slot_erase(vector<short> &slots, int i)
+{
+    auto it = lower_bound(slots.begin(), slots.end(), i);
+    if (it != slots.end() && *it == i)
+        slots.erase(it);
+}
+
+// The first slot after i in slots, or MAX_MONSTERS.
+static int _slot_after(const vector<short> &slots, int i)
+{
+    auto it = upper_bound(slots.begin(), slots.end(), i);
+    return it == slots.end() ? MAX_MONSTERS : *it;
+}
+
+void monster_index_clear()
+{
+    _mons_live.clear();
+    _mons_listed.reset();
+    for (int x = 0; x < MONS_BUCKETS_X; ++x)
+        for (int y = 0; y < MONS_BUCKETS_Y; ++y)
+            _mons_buckets[x][y].clear();
+}
+
+// The slot of mons in env.mons, or -1 for temporary copies and anon slots,
+// for which mindex() means nothing.
+static int _mons_slot(const monster &mons)
+{
+    const monster *first = menv.buffer();
+    if (less<const monster *>()(&mons, first)
+        || !less<const monster *>()(&mons, first + MAX_MONSTERS))
+    {
+        return -1;
+    }
+    return mons.mindex();
+}
+
+void monster_index_update(const monster &mons)
+{
+    const int i = _mons_slot(mons);
+    if (i < 0)
+        return;
+
+    const coord_def now = _mons_bucket(mons.pos());
+    if (!_mons_listed[i])
+    {
+        _mons_listed.set(i);
+        _slot_insert(_mons_live, i);
+    }
+    else if (_mons_bucket_of[i] != now)
+        _slot_erase(_mons_buckets[_mons_bucket_of[i].x][_mons_bucket_of[i].y], i);
+    else
+        return;
+
+    _slot_insert(_mons_buckets[now.x][now.y], i);
+    _mons_bucket_of[i] = now;
+}
+
+void monster_index_remove(const monster &mons)
+{
+    const int i = _mons_slot(mons);
+    if (i < 0 || !_mons_listed[i])
+        return;
+
+    _mons_listed.set(i, false);
+    _slot_erase(_mons_live, i);
+    _slot_erase(_mons_buckets[_mons_bucket_of[i].x][_mons_bucket_of[i].y], i);
+}
+
+// The first slot after i that might hold a monster that center can see
+// with the given LOS, or MAX_MONSTERS if there is none. This looks only at
+// the slots listed in the buckets around center.
+static int _next_mons_slot(int i, const coord_def &center, los_type los)
+{
+    if (los == LOS_NONE)
+        return _slot_after(_mons_live, i);
+    if (!map_bounds(center))
+        return MAX_MONSTERS;
+
+    const coord_def lo = _mons_bucket(center - coord_def(LOS_RADIUS,
+                                                         LOS_RADIUS));
+    const coord_def hi = _mons_bucket(center + coord_def(LOS_RADIUS,
+                                                         LOS_RADIUS));
+    int next = MAX_MONSTERS;
+    for (int x = lo.x; x <= hi.x; ++x)
+        for (int y = lo.y; y <= hi.y; ++y)
+            next = min(next, _slot_after(_mons_buckets[x][y], i));
+    return next;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 actor_near_iterator::actor_near_iterator(coord_def c, los_type los)
     : center(c), _los(los), viewer(nullptr), i(-1)
 {
@@ -64,7 +185,7 @@ bool actor_near_iterator::valid(const actor* a) const
 void actor_near_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
+         if ((i = _next_mons_slot(i, center, _los)) >= MAX_MONSTERS)
              return;
     while (!valid(**this));
 }
@@ -72,17 +193,15 @@ void actor_near_iterator::advance()
 //////////////////////////////////////////////////////////////////////////
 
 monster_near_iterator::monster_near_iterator(coord_def c, los_type los)
-    : center(c), _los(los), viewer(nullptr), i(0)
+    : center(c), _los(los), viewer(nullptr), i(-1)
 {
-    if (!valid(&menv[0]))
-        advance();
+    advance();
 }
 
 monster_near_iterator::monster_near_iterator(const actor *a, los_type los)
-    : center(a->pos()), _los(los), viewer(a), i(0)
+    : center(a->pos()), _los(los), viewer(a), i(-1)
 {
-    if (!valid(&menv[0]))
-        advance();
+    advance();
 }
 
 monster_near_iterator::operator bool() const
@@ -128,7 +247,7 @@ bool monster_near_iterator::valid(const monster* a) const
 void monster_near_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
+         if ((i = _next_mons_slot(i, center, _los)) >= MAX_MONSTERS)
              return;
     while (!valid(**this));
 }
@@ -136,10 +255,9 @@ void monster_near_iterator::advance()
 //////////////////////////////////////////////////////////////////////////
 
 monster_iterator::monster_iterator()
-    : i(0)
+    : i(-1)
 {
-    while (i < MAX_MONSTERS && !menv[i].alive())
-        i++;
+    advance();
 }
 
 monster_iterator::operator bool() const
@@ -162,9 +280,7 @@ monster* monster_iterator::operator->() const
 
 monster_iterator& monster_iterator::operator++()
 {
-    while (++i < MAX_MONSTERS)
-        if (menv[i].alive())
-            break;
+    advance();
     return *this;
 }
 
@@ -178,7 +294,7 @@ monster_iterator monster_iterator::operator++(int)
 void monster_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
+         if ((i = _next_mons_slot(i, coord_def(), LOS_NONE)) >= MAX_MONSTERS)
              return;
     while (!(*this)->alive());
 }
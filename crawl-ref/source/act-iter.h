@@ -6,6 +6,15 @@
 #ifndef ACT_ITER_H
 #define ACT_ITER_H
 
+// The iterators below use an index of which env.mons slots are in use and
+// roughly where their monsters are. Filling a slot with get_free_monster()
+// or a monster copy, moving a monster with set_position(), and resetting a
+// dead monster keep it up to date; code that sets monster::position
+// directly must call monster_index_update() itself.
+void monster_index_update(const monster &mons);
+void monster_index_remove(const monster &mons);
+void monster_index_clear();
+
 class actor_near_iterator
 {
 public:
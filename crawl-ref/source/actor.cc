@@ -141,6 +141,8 @@ void actor::set_position(const coord_def &c)
     position = c;
     los_actor_moved(this, oldpos);
     areas_actor_moved(this, oldpos);
+    if (is_monster())
+        monster_index_update(*as_monster());
 }
 
 bool actor::can_hibernate(bool holi_only, bool intrinsic_only) const
@@ -1137,6 +1137,7 @@ void arena_placed_monster(monster* mons)
         // Set the "drop" time here in case the monster drops the
         // item without dying, like being polymorphed.
         arena::item_drop_times[ii->index()] = arena::turns;
+        refresh_item_age(ii->index());
     }
 
     if (arena::name_monsters && !mons->is_named())
@@ -1256,7 +1257,10 @@ void arena_monster_died(monster* mons, killer_type killer,
     }
 
     if (corpse)
+    {
         arena::item_drop_times[corpse->index()] = arena::turns;
+        refresh_item_age(corpse->index());
+    }
 
     // Won't be dropping any items.
     if (mons->flags & MF_HARD_RESET)
@@ -1268,14 +1272,10 @@ void arena_monster_died(monster* mons, killer_type killer,
             continue;
 
         arena::item_drop_times[ii->index()] = arena::turns;
+        refresh_item_age(ii->index());
     }
 }
 
-static bool _sort_by_age(int a, int b)
-{
-    return arena::item_drop_times[a] < arena::item_drop_times[b];
-}
-
 #define DESTROY_ITEM(i) \
 { \
     destroy_item(i, true); \
@@ -1289,37 +1289,28 @@ static bool _sort_by_age(int a, int b)
 // newest items last. Items which a monster dropped voluntarily or
 // because of being polymorphed, rather than because of dying, are
 // culled earlier than they should be, but it's not like we have to be
-// fair to the arena monsters.
+// fair to the arena monsters. Dropped items are moved to the young end
+// of the item age order when their drop time is set, so that order is
+// the one to follow.
 int arena_cull_items()
 {
-    vector<int> items;
-
     int first_avail = NON_ITEM;
 
-    for (int i = 0; i < MAX_ITEMS; i++)
-    {
-        // All items in mitm[] are valid when we're called.
-        const item_def &item(mitm[i]);
-
-        // We want floor items.
-        if (!in_bounds(item.pos))
-            continue;
-
-        items.push_back(i);
-    }
-
-    // Cull half of items on the floor.
-    const int cull_target = items.size() / 2;
+    // Cull half of the items.
+    const int cull_target = items_in_use() / 2;
           int cull_count  = 0;
 
-    sort(items.begin(), items.end(), _sort_by_age);
-
     vector<int> ammo;
 
-    for (int idx : items)
+    for (int idx = oldest_item(), next; idx != NON_ITEM; idx = next)
     {
+        next = younger_item(idx);
         const item_def &item(mitm[idx]);
 
+        // We want floor items.
+        if (!item.defined() || !in_bounds(item.pos))
+            continue;
+
         // If the drop time is 0 then this is probably thrown ammo.
         if (arena::item_drop_times[idx] == 0)
         {
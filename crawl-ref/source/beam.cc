@@ -1175,21 +1175,48 @@ void bolt::affect_cell()
         affect_ground();
 }
 
-static void _undo_tracer(bolt &orig, bolt &copy)
-{
-    // FIXME: we should have a better idea of what gets changed!
-    orig.target           = copy.target;
-    orig.source           = copy.source;
-    orig.aimed_at_spot    = copy.aimed_at_spot;
-    orig.extra_range_used = copy.extra_range_used;
-    orig.auto_hit         = copy.auto_hit;
-    orig.ray              = copy.ray;
-    orig.colour           = copy.colour;
-    orig.flavour          = copy.flavour;
-    orig.real_flavour     = copy.real_flavour;
-    orig.bounces          = copy.bounces;
-    orig.bounce_pos       = copy.bounce_pos;
-}
+// The fields that firing a tracer can change and that fire() puts back
+// afterwards. Saving just these is much cheaper than copying the bolt.
+struct tracer_state
+{
+    coord_def target;
+    coord_def source;
+    bool aimed_at_spot;
+    int extra_range_used;
+    bool auto_hit;
+    ray_def ray;
+    colour_t colour;
+    beam_type flavour;
+    beam_type real_flavour;
+    int bounces;
+    coord_def bounce_pos;
+
+    explicit tracer_state(const bolt &beam)
+        : target(beam.target), source(beam.source),
+          aimed_at_spot(beam.aimed_at_spot),
+          extra_range_used(beam.extra_range_used), auto_hit(beam.auto_hit),
+          ray(beam.ray), colour(beam.colour), flavour(beam.flavour),
+          real_flavour(beam.real_flavour), bounces(beam.bounces),
+          bounce_pos(beam.bounce_pos)
+    {
+    }
+
+    void restore(bolt &beam) const
+    {
+        // FIXME: we should have a better idea of what gets changed!
+        beam.target           = target;
+        beam.source           = source;
+        beam.aimed_at_spot    = aimed_at_spot;
+        beam.extra_range_used = extra_range_used;
+        beam.auto_hit         = auto_hit;
+        beam.ray              = ray;
+        beam.colour           = colour;
+        beam.flavour          = flavour;
+        beam.real_flavour     = real_flavour;
+        beam.bounces          = bounces;
+        beam.bounce_pos       = bounce_pos;
+    }
+};
 
 // This saves some important things before calling fire().
 void bolt::fire()
@@ -1201,19 +1228,17 @@ void bolt::fire()
 
     if (is_tracer)
     {
-        bolt boltcopy = *this;
-        if (special_explosion != nullptr)
-            boltcopy.special_explosion = new bolt(*special_explosion);
-
-        do_fire();
-
+        const tracer_state saved(*this);
         if (special_explosion != nullptr)
         {
-            _undo_tracer(*special_explosion, *boltcopy.special_explosion);
-            delete boltcopy.special_explosion;
+            const tracer_state saved_explosion(*special_explosion);
+            do_fire();
+            saved_explosion.restore(*special_explosion);
         }
+        else
+            do_fire();
 
-        _undo_tracer(*this, boltcopy);
+        saved.restore(*this);
     }
     else
         do_fire();
@@ -2198,6 +2223,108 @@ int silver_damages_victim(actor* victim, int damage, string &dmg_msg)
     return ret;
 }
 
+// What a cached tracer result depends on, beyond the state of the level.
+struct tracer_key
+{
+    mid_t source_id;
+    coord_def source;
+    coord_def target;
+    int range;
+    beam_type flavour;
+    beam_type real_flavour;
+    spell_type origin_spell;
+    int damage_num;
+    int damage_size;
+    int hit;
+    int ench_power;
+    int ex_size;
+    int foe_ratio;
+    mon_attitude_type attitude;
+    bool aimed_at_spot;
+    bool pierce;
+    bool affects_nothing;
+    bool is_explosion;
+    bool explode_only;
+    bool explosion_hole;
+
+    tracer_key(const bolt &beam, bool explode, bool hole)
+        : source_id(beam.source_id), source(beam.source),
+          target(beam.target), range(beam.range), flavour(beam.flavour),
+          real_flavour(beam.real_flavour), origin_spell(beam.origin_spell),
+          damage_num(beam.damage.num), damage_size(beam.damage.size),
+          hit(beam.hit), ench_power(beam.ench_power), ex_size(beam.ex_size),
+          foe_ratio(beam.foe_ratio), attitude(beam.attitude),
+          aimed_at_spot(beam.aimed_at_spot), pierce(beam.pierce),
+          affects_nothing(beam.affects_nothing),
+          is_explosion(beam.is_explosion),
+          explode_only(explode), explosion_hole(hole)
+    {
+    }
+
+    bool operator==(const tracer_key &other) const
+    {
+        return source_id == other.source_id
+               && source == other.source
+               && target == other.target
+               && range == other.range
+               && flavour == other.flavour
+               && real_flavour == other.real_flavour
+               && origin_spell == other.origin_spell
+               && damage_num == other.damage_num
+               && damage_size == other.damage_size
+               && hit == other.hit
+               && ench_power == other.ench_power
+               && ex_size == other.ex_size
+               && foe_ratio == other.foe_ratio
+               && attitude == other.attitude
+               && aimed_at_spot == other.aimed_at_spot
+               && pierce == other.pierce
+               && affects_nothing == other.affects_nothing
+               && is_explosion == other.is_explosion
+               && explode_only == other.explode_only
+               && explosion_hole == other.explosion_hole;
+    }
+};
+
+// What a tracer reports back to the monster that fired it.
+struct tracer_result
+{
+    tracer_info foe_info;
+    tracer_info friend_info;
+    vector<coord_def> path_taken;
+    bool seen;
+    bool heard;
+
+    explicit tracer_result(const bolt &beam)
+        : foe_info(beam.foe_info), friend_info(beam.friend_info),
+          path_taken(beam.path_taken), seen(beam.seen), heard(beam.heard)
+    {
+    }
+
+    void apply(bolt &beam) const
+    {
+        beam.foe_info    = foe_info;
+        beam.friend_info = friend_info;
+        beam.path_taken  = path_taken;
+        beam.seen        = seen;
+        beam.heard       = heard;
+    }
+};
+
+static int _tracer_cache_depth = 0;
+static vector<pair<tracer_key, tracer_result>> _tracer_cache;
+
+tracer_cache_scope::tracer_cache_scope()
+{
+    ++_tracer_cache_depth;
+}
+
+tracer_cache_scope::~tracer_cache_scope()
+{
+    if (--_tracer_cache_depth == 0)
+        _tracer_cache.clear();
+}
+
 //  Used by monsters in "planning" which spell to cast. Fires off a "tracer"
 //  which tells the monster what it'll hit if it breathes/casts etc.
 //
@@ -2242,8 +2369,29 @@ void fire_tracer(const monster* mons, bolt &pbolt, bool explode_only,
 
     pbolt.in_explosion_phase = false;
 
+    // Exploding missiles point at a bolt we don't own, so aren't cached.
+    const bool cacheable = _tracer_cache_depth > 0
+                           && pbolt.special_explosion == nullptr;
+    if (cacheable)
+    {
+        const tracer_key key(pbolt, explode_only, explosion_hole);
+        auto cached = find_if(_tracer_cache.begin(), _tracer_cache.end(),
+                              [&key](const pair<tracer_key,
+                                                   tracer_result> &entry)
+                              { return entry.first == key; });
+        if (cached != _tracer_cache.end())
+            cached->second.apply(pbolt);
+        else
+        {
+            if (explode_only)
+                pbolt.explode(false, explosion_hole);
+            else
+                pbolt.fire();
+            _tracer_cache.emplace_back(key, tracer_result(pbolt));
+        }
+    }
     // Fire!
-    if (explode_only)
+    else if (explode_only)
         pbolt.explode(false, explosion_hole);
     else
         pbolt.fire();
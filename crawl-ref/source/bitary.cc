@@ -7,17 +7,49 @@
 
 #include "bitary.h"
 
+#if defined(__AVX2__)
+# include <immintrin.h>
+typedef __m256i simd_block;
+# define SIMD_LOAD(p)     _mm256_loadu_si256((const simd_block*)(p))
+# define SIMD_STORE(p, v) _mm256_storeu_si256((simd_block*)(p), (v))
+# define SIMD_OR(a, b)    _mm256_or_si256((a), (b))
+# define SIMD_AND(a, b)   _mm256_and_si256((a), (b))
+# define USE_SIMD_BITS
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+typedef __m128i simd_block;
+# define SIMD_LOAD(p)     _mm_loadu_si128((const simd_block*)(p))
+# define SIMD_STORE(p, v) _mm_storeu_si128((simd_block*)(p), (v))
+# define SIMD_OR(a, b)    _mm_or_si128((a), (b))
+# define SIMD_AND(a, b)   _mm_and_si128((a), (b))
+# define USE_SIMD_BITS
+#endif
+
+#ifdef USE_SIMD_BITS
+static const int BLOCK_WORDS = sizeof(simd_block) / sizeof(unsigned long);
+#else
+static const int BLOCK_WORDS = 1;
+#endif
+
+// Pad the storage to whole SIMD blocks, so that the word loops below
+// need no scalar tail. The padding bits stay zero.
+static int _nwords(unsigned long size)
+{
+    const int w = static_cast<int>((size + LONGSIZE - 1) / LONGSIZE);
+    return (w + BLOCK_WORDS - 1) / BLOCK_WORDS * BLOCK_WORDS;
+}
+
 bit_vector::bit_vector(unsigned long s)
     : size(s)
 {
-    nwords = static_cast<int>((size + LONGSIZE - 1) / LONGSIZE);
+    nwords = _nwords(size);
     data = new unsigned long[nwords];
     reset();
 }
 
 bit_vector::bit_vector(const bit_vector& other) : size(other.size)
 {
-    nwords = static_cast<int>((size + LONGSIZE - 1) / LONGSIZE);
+    nwords = _nwords(size);
     data = new unsigned long[nwords];
     for (int w = 0; w < nwords; ++w)
         data[w] = other.data[w];
@@ -56,16 +88,51 @@ void bit_vector::set(unsigned long index, bool value)
 bit_vector& bit_vector::operator |= (const bit_vector& other)
 {
     ASSERT(size == other.size);
+#ifdef USE_SIMD_BITS
+    for (int w = 0; w < nwords; w += BLOCK_WORDS)
+    {
+        SIMD_STORE(data + w, SIMD_OR(SIMD_LOAD(data + w),
+                                     SIMD_LOAD(other.data + w)));
+    }
+#else
     for (int w = 0; w < nwords; ++w)
         data[w] |= other.data[w];
+#endif
     return *this;
 }
 
 bit_vector& bit_vector::operator &= (const bit_vector& other)
 {
     ASSERT(size == other.size);
+#ifdef USE_SIMD_BITS
+    for (int w = 0; w < nwords; w += BLOCK_WORDS)
+    {
+        SIMD_STORE(data + w, SIMD_AND(SIMD_LOAD(data + w),
+                                      SIMD_LOAD(other.data + w)));
+    }
+#else
     for (int w = 0; w < nwords; ++w)
         data[w] &= other.data[w];
+#endif
+    return *this;
+}
+
+bit_vector& bit_vector::or_and(const bit_vector& a, const bit_vector& b)
+{
+    ASSERT(size == a.size);
+    ASSERT(size == b.size);
+#ifdef USE_SIMD_BITS
+    for (int w = 0; w < nwords; w += BLOCK_WORDS)
+    {
+        SIMD_STORE(data + w,
+                   SIMD_OR(SIMD_LOAD(data + w),
+                           SIMD_AND(SIMD_LOAD(a.data + w),
+                                    SIMD_LOAD(b.data + w))));
+    }
+#else
+    for (int w = 0; w < nwords; ++w)
+        data[w] |= a.data[w] & b.data[w];
+#endif
     return *this;
 }
 
@@ -29,9 +29,16 @@ public:
     bit_vector& operator &= (const bit_vector& other);
     bit_vector  operator & (const bit_vector& other) const;
 
+    // *this |= a & b, without allocating a temporary.
+    bit_vector& or_and(const bit_vector& a, const bit_vector& b);
+
+    // Raw access for word-parallel scans. Bits past size are always 0.
+    int words() const { return nwords; }
+    unsigned long word(int w) const { return data[w]; }
+
 protected:
     unsigned long size;
-    int nwords;
+    int nwords;       // Rounded up to a whole number of SIMD blocks.
     unsigned long *data;
 };
 
@@ -40,6 +47,22 @@ protected:
 #define ULONG_MAX ((unsigned long)(-1))
 #endif
 
+// Index of the lowest set bit of a nonzero word.
+static inline int lowest_set_bit(unsigned long w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzl(w);
+#else
+    int i = 0;
+    while (!(w & 1))
+    {
+        w >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
 template <unsigned int SIZE> class FixedBitVector
 {
 protected:
@@ -9,6 +9,7 @@
 
 #include <cstdlib>
 #include <fcntl.h>
+#include <unordered_map>
 #include <sys/stat.h>
 #include <sys/types.h>
 #ifndef TARGET_COMPILER_VC
@@ -26,8 +27,11 @@
 #include "threads.h"
 #include "unicode.h"
 
+typedef pair<const string, string> db_entry;
+
 // TextDB handles dependency checking the db vs text files, creating the
-// db, loading, and destroying the DB.
+// db, loading, and destroying the DB. Once loaded, the whole DB is kept
+// in memory, so lookups and searches don't go back to the DBM.
 class TextDB
 {
 public:
@@ -38,22 +42,34 @@ public:
     ~TextDB() { shutdown(true); delete translation; }
     void init();
     void shutdown(bool recursive = false);
-    DBM* get() { return _db; }
 
-    // Make it easier to migrate from raw DBM* to TextDB
-    operator bool() const { return _db != 0; }
-    operator DBM*() const { return _db; }
+    operator bool() const { return _loaded; }
+
+    // The body for a key, or nullptr if there is none.
+    const string *find(const string &key) const;
+    // All entries, in the order the DBM listed them.
+    const vector<const db_entry *> &entries() const { return _order; }
+    bool body_candidates(const string &text,
+                         vector<uint32_t> &candidates) const;
 
  private:
     bool _needs_update() const;
     void _regenerate_db();
+    void _load_entries(DBM *db);
+    void _index_bodies() const;
 
  private:
     bool open_db();
     const char* const _db_name;
     string _directory;
     vector<string> _input_files;
-    DBM* _db;
+    bool _loaded;
+    unordered_map<string, string> _entries;
+    vector<const db_entry *> _order;
+    // For each trigram of lowercased text, the (indices into _order of)
+    // entries whose body contains it. Built by the first body search.
+    mutable unordered_map<uint32_t, vector<uint32_t>> _body_trigrams;
+    mutable bool _bodies_indexed;
     string timestamp;
     TextDB *_parent;
     const char* lang() { return _parent ? Options.lang_name : 0; }
@@ -165,7 +181,8 @@ static string _db_cache_path(string db, const char *lang)
 
 TextDB::TextDB(const char* db_name, const char* dir, ...)
     : _db_name(db_name), _directory(dir),
-      _db(nullptr), timestamp(""), _parent(0), translation(0)
+      _loaded(false), _bodies_indexed(false), timestamp(""), _parent(0),
+      translation(0)
 {
     va_list args;
     va_start(args, dir);
@@ -187,20 +204,24 @@ TextDB::TextDB(TextDB *parent)
     : _db_name(parent->_db_name),
       _directory(parent->_directory + Options.lang_name + "/"),
       _input_files(parent->_input_files), // FIXME: pointless copy
-      _db(nullptr), timestamp(""), _parent(parent), translation(nullptr)
+      _loaded(false), _bodies_indexed(false), timestamp(""),
+      _parent(parent), translation(nullptr)
 {
 }
 
 bool TextDB::open_db()
 {
-    if (_db)
+    if (_loaded)
         return true;
 
     const string full_db_path = _db_cache_path(_db_name, lang());
-    _db = dbm_open(full_db_path.c_str(), O_RDONLY, 0660);
-    if (!_db)
+    DBM *db = dbm_open(full_db_path.c_str(), O_RDONLY, 0660);
+    if (!db)
         return false;
 
+    _load_entries(db);
+    dbm_close(db);
+
     timestamp = _query_database(*this, "TIMESTAMP", false, false, true);
     if (timestamp.empty())
         return false;
@@ -220,6 +241,9 @@ void TextDB::init()
 
     if (!_needs_update())
         return;
+
+    // Drop the entries open_db() loaded, so the new DB is read back in.
+    shutdown();
     _regenerate_db();
 
     if (!open_db())
@@ -231,11 +255,12 @@ void TextDB::init()
 
 void TextDB::shutdown(bool recursive)
 {
-    if (_db)
-    {
-        dbm_close(_db);
-        _db = nullptr;
-    }
+    _entries.clear();
+    _order.clear();
+    _body_trigrams.clear();
+    _bodies_indexed = false;
+    _loaded = false;
+    timestamp.clear();
     if (recursive && translation)
         translation->shutdown(recursive);
 }
@@ -277,7 +302,6 @@ bool TextDB::_needs_update() const
 
 void TextDB::_regenerate_db()
 {
-    shutdown();
 #ifdef DEBUG_DIAGNOSTICS
     if (_parent)
         printf("Regenerating db: %s [%s]\n", _db_name, Options.lang_name);
@@ -300,7 +324,8 @@ void TextDB::_regenerate_db()
 #endif
 
     string ts;
-    if (!(_db = dbm_open(db_path.c_str(), O_RDWR | O_CREAT, 0660)))
+    DBM *db = dbm_open(db_path.c_str(), O_RDWR | O_CREAT, 0660);
+    if (!db)
         end(1, true, "Unable to open DB: %s", db_path.c_str());
     for (const string &file : _input_files)
     {
@@ -318,13 +343,95 @@ void TextDB::_regenerate_db()
 #endif
             || !_parent) // english is mandatory
         {
-            _store_text_db(full_input_path, _db);
+            _store_text_db(full_input_path, db);
+        }
+    }
+    _add_entry(db, "TIMESTAMP", ts);
+
+    dbm_close(db);
+}
+
+// Reads every entry of the DBM into memory: one pass at startup instead of
+// a query per key each time something is looked up.
+void TextDB::_load_entries(DBM *db)
+{
+    for (datum dbKey = dbm_firstkey(db); dbKey.dptr != nullptr;
+         dbKey = dbm_nextkey(db))
+    {
+        datum dbBody = dbm_fetch(db, dbKey);
+        auto added = _entries.emplace(
+            string((const char *)dbKey.dptr, dbKey.dsize),
+            string((const char *)dbBody.dptr, dbBody.dsize));
+        if (added.second)
+            _order.push_back(&*added.first);
+    }
+    _loaded = true;
+}
+
+const string *TextDB::find(const string &key) const
+{
+    auto entry = _entries.find(key);
+    if (entry == _entries.end() || entry->second.empty())
+        return nullptr;
+    return &entry->second;
+}
+
+void TextDB::_index_bodies() const
+{
+    vector<uint32_t> trigrams;
+    for (uint32_t i = 0; i < _order.size(); ++i)
+    {
+        trigrams.clear();
+        add_trigrams(lowercase_string(_order[i]->second), trigrams);
+        sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(unique(trigrams.begin(), trigrams.end()),
+                       trigrams.end());
+        for (uint32_t trigram : trigrams)
+            _body_trigrams[trigram].push_back(i);
+    }
+    _bodies_indexed = true;
+}
+
+// Finds the entries whose body might contain text, ignoring case. Returns
+// false if text is too short to narrow things down, and every entry has to
+// be checked.
+bool TextDB::body_candidates(const string &text,
+                             vector<uint32_t> &candidates) const
+{
+    vector<uint32_t> wanted;
+    add_trigrams(lowercase_string(text), wanted);
+    if (wanted.empty())
+        return false;
+
+    if (!_bodies_indexed)
+        _index_bodies();
+
+    vector<const vector<uint32_t> *> postings;
+    for (uint32_t trigram : wanted)
+    {
+        auto found = _body_trigrams.find(trigram);
+        if (found == _body_trigrams.end())
+        {
+            candidates.clear();
+            return true;
         }
+        postings.push_back(&found->second);
     }
-    _add_entry(_db, "TIMESTAMP", ts);
 
-    dbm_close(_db);
-    _db = 0;
+    // Intersect, starting with the rarest trigram.
+    sort(postings.begin(), postings.end(),
+         [](const vector<uint32_t> *a, const vector<uint32_t> *b)
+         { return a->size() < b->size(); });
+    candidates = *postings[0];
+    for (size_t i = 1; i < postings.size() && !candidates.empty(); ++i)
+    {
+        vector<uint32_t> both;
+        set_intersection(candidates.begin(), candidates.end(),
+                         postings[i]->begin(), postings[i]->end(),
+                         back_inserter(both));
+        candidates.swap(both);
+    }
+    return true;
 }
 
 // ----------------------------------------------------------------------
@@ -375,24 +482,20 @@ void databaseSystemShutdown()
 ////////////////////////////////////////////////////////////////////////////
 // Main DB functions
 
-static datum _database_fetch(DBM *database, const string &key)
+// Looks key up in db's translation, if it has one, then in db itself.
+static const string *_database_fetch(const TextDB &db, const string &key,
+                                     bool untranslated = false)
 {
-    datum result;
-    result.dptr = nullptr;
-    result.dsize = 0;
-    datum dbKey;
-
-    dbKey.dptr = (DPTR_COERCE) key.c_str();
-    dbKey.dsize = key.length();
-
-    // Don't use the database if called from "monster".
-    if (database)
-        result = dbm_fetch(database, dbKey);
+    const string *result = nullptr;
+    if (db.translation && !untranslated)
+        result = db.translation->find(key);
+    if (!result)
+        result = db.find(key);
 
     return result;
 }
 
-static vector<string> _database_find_keys(DBM *database,
+static vector<string> _database_find_keys(const TextDB &database,
                                           const string &regex,
                                           bool ignore_case,
                                           db_find_filter filter = nullptr)
@@ -400,11 +503,9 @@ static vector<string> _database_find_keys(DBM *database,
     text_pattern             tpat(regex, ignore_case);
     vector<string> matches;
 
-    datum dbKey = dbm_firstkey(database);
-
-    while (dbKey.dptr != nullptr)
+    for (const db_entry *entry : database.entries())
     {
-        string key((const char *)dbKey.dptr, dbKey.dsize);
+        const string &key = entry->first;
 
         if (tpat.matches(key)
             && key.find("__") == string::npos
@@ -412,40 +513,47 @@ static vector<string> _database_find_keys(DBM *database,
         {
             matches.push_back(key);
         }
-
-        dbKey = dbm_nextkey(database);
     }
 
     return matches;
 }
 
-static vector<string> _database_find_bodies(DBM *database,
+static bool _db_body_matches(const db_entry &entry, const text_pattern &tpat,
+                             db_find_filter filter)
+{
+    const string &key = entry.first;
+    const string &body = entry.second;
+
+    return tpat.matches(body)
+           && key.find("__") == string::npos
+           && (filter == nullptr || !(*filter)(key, body));
+}
+
+static vector<string> _database_find_bodies(const TextDB &database,
                                             const string &regex,
                                             bool ignore_case,
                                             db_find_filter filter = nullptr)
 {
     text_pattern             tpat(regex, ignore_case);
     vector<string> matches;
+    const vector<const db_entry *> &entries = database.entries();
 
-    datum dbKey = dbm_firstkey(database);
-
-    while (dbKey.dptr != nullptr)
+    // A search for plain text only needs to look at the bodies that
+    // contain all of its trigrams.
+    vector<uint32_t> candidates;
+    if (regex.find_first_of("\\^$.|?*+()[]{}") == string::npos
+        && database.body_candidates(regex, candidates))
     {
-        string key((const char *)dbKey.dptr, dbKey.dsize);
-
-        datum dbBody = dbm_fetch(database, dbKey);
-        string body((const char *)dbBody.dptr, dbBody.dsize);
-
-        if (tpat.matches(body)
-            && key.find("__") == string::npos
-            && (filter == nullptr || !(*filter)(key, body)))
-        {
-            matches.push_back(key);
-        }
-
-        dbKey = dbm_nextkey(database);
+        for (uint32_t i : candidates)
+            if (_db_body_matches(*entries[i], tpat, filter))
+                matches.push_back(entries[i]->first);
+        return matches;
     }
 
+    for (const db_entry *entry : entries)
+        if (_db_body_matches(*entry, tpat, filter))
+            matches.push_back(entry->first);
+
     return matches;
 }
 
@@ -627,33 +735,22 @@ static string _getWeightedString(TextDB &db, const string &key,
     lowercase(canonical_key);
 
     // Query the DB.
-    datum result;
-
-    if (db.translation)
-        result = _database_fetch(db.translation->get(), canonical_key);
-    if (result.dsize <= 0)
-        result = _database_fetch(db.get(), canonical_key);
+    const string *result = _database_fetch(db, canonical_key);
 
-    if (result.dsize <= 0)
+    if (!result)
     {
         // Try ignoring the suffix.
         canonical_key = key;
         lowercase(canonical_key);
 
         // Query the DB.
-        if (db.translation)
-            result = _database_fetch(db.translation->get(), canonical_key);
-        if (result.dsize <= 0)
-            result = _database_fetch(db.get(), canonical_key);
+        result = _database_fetch(db, canonical_key);
 
-        if (result.dsize <= 0)
+        if (!result)
             return "";
     }
 
-    // Cons up a (C++) string to return. The caller must release it.
-    string str = string((const char *)result.dptr, result.dsize);
-
-    return _chooseStrByWeight(str, fixed_weight);
+    return _chooseStrByWeight(*result, fixed_weight);
 }
 
 static void _call_recursive_replacement(string &str, TextDB &db,
@@ -741,17 +838,12 @@ static string _query_database(TextDB &db, string key, bool canonicalise_key,
     }
 
     // Query the DB.
-    datum result;
-
-    if (db.translation && !untranslated)
-        result = _database_fetch(db.translation->get(), key);
-    if (result.dsize <= 0)
-        result = _database_fetch(db.get(), key);
+    const string *result = _database_fetch(db, key, untranslated);
 
-    if (result.dsize <= 0)
+    if (!result)
         return "";
 
-    string str((const char *)result.dptr, result.dsize);
+    string str = *result;
 
     // <foo> is an alias to key foo
     if (str[0] == '<' && str[str.size() - 2] == '>'
@@ -787,7 +879,7 @@ string getLongDescription(const string &key)
 vector<string> getLongDescKeysByRegex(const string &regex,
                                       db_find_filter filter)
 {
-    if (!DescriptionDB.get())
+    if (!DescriptionDB)
     {
         vector<string> empty;
         return empty;
@@ -795,13 +887,13 @@ vector<string> getLongDescKeysByRegex(const string &regex,
 
     // FIXME: need to match regex against translated keys, which can't
     // be done by db only.
-    return _database_find_keys(DescriptionDB.get(), regex, true, filter);
+    return _database_find_keys(DescriptionDB, regex, true, filter);
 }
 
 vector<string> getLongDescBodiesByRegex(const string &regex,
                                         db_find_filter filter)
 {
-    if (!DescriptionDB.get())
+    if (!DescriptionDB)
     {
         vector<string> empty;
         return empty;
@@ -810,9 +902,8 @@ vector<string> getLongDescBodiesByRegex(const string &regex,
     // On partial translations, this will match only translated descriptions.
     // Not good, but otherwise we'd have to check hundreds of keys, with
     // two queries for each.
-    // SQL can do this in one go, DBM can't.
-    DBM *database = DescriptionDB.translation ?
-        DescriptionDB.translation->get() : DescriptionDB.get();
+    const TextDB &database = DescriptionDB.translation ?
+        *DescriptionDB.translation : DescriptionDB;
     return _database_find_bodies(database, regex, true, filter);
 }
 
@@ -871,13 +962,13 @@ string getHelpString(const string &topic)
 // FAQ DB specific functions.
 vector<string> getAllFAQKeys()
 {
-    if (!FAQDB.get())
+    if (!FAQDB)
     {
         vector<string> empty;
         return empty;
     }
 
-    return _database_find_keys(FAQDB.get(), "^q.+", false);
+    return _database_find_keys(FAQDB, "^q.+", false);
 }
 
 string getFAQ_Question(const string &key)
@@ -920,3 +1011,22 @@ string getHintString(const string &key)
 {
     return unwrap_desc(_query_database(HintsDB, key, true, true));
 }
+
+#ifdef DEBUG_TESTS
+/////////////////////////////////////////////////////////////////////////////
+// Test support.
+
+// Looks key up in, and searches the bodies of, a DB built from
+// test/textdb.txt. Every call goes through init(), as startup does, so a
+// change to the file must show up in the next call's results.
+string database_test_lookup(const string &key, const string &body_text,
+                            vector<string> &body_matches)
+{
+    static TextDB db("test_textdb", "test/", "textdb.txt", nullptr);
+    db.init();
+
+    body_matches = _database_find_bodies(db, body_text, true);
+    const string *body = db.find(key);
+    return body ? *body : "";
+}
+#endif
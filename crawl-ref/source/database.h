@@ -50,4 +50,9 @@ string getHintString(const string &key);
 vector<string> getAllFAQKeys();
 string getFAQ_Question(const string &key);
 string getFAQ_Answer(const string &question);
+
+#ifdef DEBUG_TESTS
+string database_test_lookup(const string &key, const string &body_text,
+                            vector<string> &body_matches);
+#endif
 #endif
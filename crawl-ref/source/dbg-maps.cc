@@ -7,6 +7,11 @@
 
 #include "dbg-maps.h"
 
+#ifndef TARGET_OS_WINDOWS
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "branch.h"
 #include "chardump.h"
 #include "crash.h"
@@ -19,9 +24,11 @@
 #include "message.h"
 #include "ng-init.h"
 #include "player.h"
+#include "random.h"
 #include "shopping.h"
 #include "state.h"
 #include "stringutil.h"
+#include "tags.h"
 #include "view.h"
 
 #ifdef DEBUG_STATISTICS
@@ -46,6 +53,10 @@ static int build_attempts = 0, level_vetoes = 0;
 // Map from message to counts.
 static map<string, int> veto_messages;
 
+// Whether this is one of several processes sharing the iterations; if so,
+// leave the terminal to the parent.
+static bool in_shard = false;
+
 void mapstat_report_map_build_start()
 {
     build_attempts++;
@@ -73,19 +84,22 @@ static bool _is_disconnected_level()
 
 static bool _do_build_level()
 {
-    clear_messages();
-    mprf("On %s; %d g, %d fail, %u err%s, %u uniq, "
-         "%d try, %d (%.2f%%) vetos",
-         level_id::current().describe().c_str(), levels_tried, levels_failed,
-         (unsigned int)errors.size(), last_error.empty() ? ""
-         : (" (" + last_error + ")").c_str(), (unsigned int) use_count.size(),
-         build_attempts, level_vetoes,
-         build_attempts ? level_vetoes * 100.0 / build_attempts : 0.0);
+    if (!in_shard)
+    {
+        clear_messages();
+        mprf("On %s; %d g, %d fail, %u err%s, %u uniq, "
+             "%d try, %d (%.2f%%) vetos",
+             level_id::current().describe().c_str(), levels_tried,
+             levels_failed, (unsigned int)errors.size(), last_error.empty()
+             ? "" : (" (" + last_error + ")").c_str(),
+             (unsigned int) use_count.size(), build_attempts, level_vetoes,
+             build_attempts ? level_vetoes * 100.0 / build_attempts : 0.0);
+    }
 
     watchdog();
 
     no_messages mx;
-    if (kbhit() && key_is_escape(getchk()))
+    if (!in_shard && kbhit() && key_is_escape(getchk()))
     {
         mprf(MSGCH_WARN, "User requested cancel");
         return false;
@@ -223,6 +237,266 @@ static bool _build_dungeon()
     return true;
 }
 
+// Build iterations [first, last).
+static bool _build_iterations(int first, int last)
+{
+    for (int i = first; i < last; ++i)
+    {
+        if (!in_shard)
+        {
+            clear_messages();
+            mprf("On %d of %d; %d g, %d fail, %u err%s, %u uniq, "
+                 "%d try, %d (%.2f%%) vetoes",
+                 i, SysEnv.map_gen_iters, levels_tried, levels_failed,
+                 (unsigned int)errors.size(),
+                 last_error.empty() ? "" : (" (" + last_error + ")").c_str(),
+                 (unsigned int)use_count.size(), build_attempts, level_vetoes,
+                 build_attempts ? level_vetoes * 100.0 / build_attempts : 0.0);
+        }
+        printf("%d..", i + 1);
+        fflush(stdout);
+        dlua.callfn("dgn_clear_data", "");
+        you.uniq_map_tags.clear();
+        you.uniq_map_names.clear();
+        you.unique_creatures.reset();
+        initialise_branch_depths();
+        init_level_connectivity();
+        if (!_build_dungeon())
+            return false;
+        if (crawl_state.obj_stat_gen)
+            objstat_iteration_stats();
+    }
+    return true;
+}
+
+#ifndef TARGET_OS_WINDOWS
+static void _write_key(writer &outf, const level_id &lid)
+{
+    marshall_level_id(outf, lid);
+}
+
+static void _write_key(writer &outf, const string &name)
+{
+    marshallString(outf, name);
+}
+
+static void _read_key(reader &inf, level_id &lid)
+{
+    lid = unmarshall_level_id(inf);
+}
+
+static void _read_key(reader &inf, string &name)
+{
+    name = unmarshallString(inf);
+}
+
+template<typename K>
+static void _write_counts(writer &outf, const map<K, int> &counts)
+{
+    marshallInt(outf, counts.size());
+    for (const auto &entry : counts)
+    {
+        _write_key(outf, entry.first);
+        marshallInt(outf, entry.second);
+    }
+}
+
+template<typename K>
+static void _merge_counts(reader &inf, map<K, int> &counts)
+{
+    for (int n = unmarshallInt(inf); n > 0; --n)
+    {
+        K key;
+        _read_key(inf, key);
+        counts[key] += unmarshallInt(inf);
+    }
+}
+
+template<typename K, typename V>
+static void _write_sets(writer &outf, const map<K, set<V> > &sets)
+{
+    marshallInt(outf, sets.size());
+    for (const auto &entry : sets)
+    {
+        _write_key(outf, entry.first);
+        marshallInt(outf, entry.second.size());
+        for (const V &val : entry.second)
+            _write_key(outf, val);
+    }
+}
+
+template<typename K, typename V>
+static void _merge_sets(reader &inf, map<K, set<V> > &sets)
+{
+    for (int n = unmarshallInt(inf); n > 0; --n)
+    {
+        K key;
+        _read_key(inf, key);
+        set<V> &vals = sets[key];
+        for (int m = unmarshallInt(inf); m > 0; --m)
+        {
+            V val;
+            _read_key(inf, val);
+            vals.insert(val);
+        }
+    }
+}
+
+static void _write_shard(writer &outf)
+{
+    marshallInt(outf, levels_tried);
+    marshallInt(outf, levels_failed);
+    marshallInt(outf, build_attempts);
+    marshallInt(outf, level_vetoes);
+    marshallString(outf, last_error);
+
+    _write_counts(outf, try_count);
+    _write_counts(outf, use_count);
+    _write_counts(outf, success_count);
+    _write_counts(outf, veto_messages);
+    _write_counts(outf, level_mapcounts);
+    _write_sets(outf, level_mapsused);
+    _write_sets(outf, map_levelsused);
+
+    marshallInt(outf, map_builds.size());
+    for (const auto &entry : map_builds)
+    {
+        marshall_level_id(outf, entry.first);
+        marshallInt(outf, entry.second.first);
+        marshallInt(outf, entry.second.second);
+    }
+
+    marshallInt(outf, errors.size());
+    for (const auto &entry : errors)
+    {
+        marshallString(outf, entry.first);
+        marshallString(outf, entry.second);
+    }
+
+    if (crawl_state.obj_stat_gen)
+        objstat_write_shard(outf);
+}
+
+static void _merge_shard(reader &inf)
+{
+    levels_tried += unmarshallInt(inf);
+    levels_failed += unmarshallInt(inf);
+    build_attempts += unmarshallInt(inf);
+    level_vetoes += unmarshallInt(inf);
+    const string err = unmarshallString(inf);
+    if (!err.empty())
+        last_error = err;
+
+    _merge_counts(inf, try_count);
+    _merge_counts(inf, use_count);
+    _merge_counts(inf, success_count);
+    _merge_counts(inf, veto_messages);
+    _merge_counts(inf, level_mapcounts);
+    _merge_sets(inf, level_mapsused);
+    _merge_sets(inf, map_levelsused);
+
+    for (int n = unmarshallInt(inf); n > 0; --n)
+    {
+        pair<int, int> &builds = map_builds[unmarshall_level_id(inf)];
+        builds.first += unmarshallInt(inf);
+        builds.second += unmarshallInt(inf);
+    }
+
+    for (int n = unmarshallInt(inf); n > 0; --n)
+    {
+        const string name = unmarshallString(inf);
+        errors[name] = unmarshallString(inf);
+    }
+
+    if (crawl_state.obj_stat_gen)
+        objstat_merge_shard(inf);
+}
+
+/**
+ * Split the iterations over SysEnv.map_gen_jobs forked processes, each
+ * with its own seed, and fold their statistics back into ours.
+ *
+ * Dungeon generation only depends on the RNG and the per-game state that
+ * each iteration resets, so every process can build from a copy of the
+ * parent as it stands before the first iteration.
+ */
+static bool _build_iterations_sharded()
+{
+    // Shards start from a copy of our statistics, which would otherwise be
+    // counted once per shard.
+    ASSERT(!levels_tried);
+
+    const int jobs = min(SysEnv.map_gen_jobs, SysEnv.map_gen_iters);
+    vector<pid_t> pids;
+    vector<FILE*> results;
+    bool ok = true;
+
+    for (int job = 0; job < jobs; ++job)
+    {
+        const uint32_t seed = get_uint32();
+        FILE *result = tmpfile();
+        if (!result)
+        {
+            perror("Can't create a file for mapstat results");
+            ok = false;
+            break;
+        }
+
+        fflush(stdout);
+        fflush(stderr);
+        const pid_t pid = fork();
+        if (pid == -1)
+        {
+            perror("Can't start a mapstat process");
+            fclose(result);
+            ok = false;
+            break;
+        }
+        if (!pid)
+        {
+            in_shard = true;
+            seed_rng(seed);
+            const int iters = SysEnv.map_gen_iters;
+            const bool built = _build_iterations(iters * job / jobs,
+                                                 iters * (job + 1) / jobs);
+            {
+                writer outf("mapstat results", result);
+                marshallBoolean(outf, built);
+                _write_shard(outf);
+            }
+            const bool written = !fflush(result);
+            fflush(stdout);
+            // Skip our copy of the parent's exit handlers and terminal.
+            _exit(written ? 0 : 1);
+        }
+        pids.push_back(pid);
+        results.push_back(result);
+    }
+
+    for (int job = 0, size = pids.size(); job < size; ++job)
+    {
+        int status;
+        if (waitpid(pids[job], &status, 0) == -1
+            || !WIFEXITED(status) || WEXITSTATUS(status))
+        {
+            fprintf(stderr, "Mapstat process %d failed.\n", job + 1);
+            ok = false;
+        }
+        else
+        {
+            rewind(results[job]);
+            reader inf(results[job]);
+            if (!unmarshallBoolean(inf))
+                ok = false;
+            _merge_shard(inf);
+        }
+        fclose(results[job]);
+    }
+
+    return ok;
+}
+#endif
+
 /**
  * Build dungeon levels for mapstat or objstat.
  *
@@ -242,29 +516,15 @@ bool mapstat_build_levels()
         _dungeon_places();
     printf("Iteration: ");
     fflush(stdout);
-    for (int i = 0; i < SysEnv.map_gen_iters; ++i)
-    {
-        clear_messages();
-        mprf("On %d of %d; %d g, %d fail, %u err%s, %u uniq, "
-             "%d try, %d (%.2f%%) vetoes",
-             i, SysEnv.map_gen_iters, levels_tried, levels_failed,
-             (unsigned int)errors.size(),
-             last_error.empty() ? "" : (" (" + last_error + ")").c_str(),
-             (unsigned int)use_count.size(), build_attempts, level_vetoes,
-             build_attempts ? level_vetoes * 100.0 / build_attempts : 0.0);
-        printf("%d..", i + 1);
-        fflush(stdout);
-        dlua.callfn("dgn_clear_data", "");
-        you.uniq_map_tags.clear();
-        you.uniq_map_names.clear();
-        you.unique_creatures.reset();
-        initialise_branch_depths();
-        init_level_connectivity();
-        if (!_build_dungeon())
-            return false;
-        if (crawl_state.obj_stat_gen)
-            objstat_iteration_stats();
-    }
+    bool built;
+#ifndef TARGET_OS_WINDOWS
+    if (SysEnv.map_gen_jobs > 1 && SysEnv.map_gen_iters > 1)
+        built = _build_iterations_sharded();
+    else
+#endif
+        built = _build_iterations(0, SysEnv.map_gen_iters);
+    if (!built)
+        return false;
     printf("Finished.\n");
     fflush(stdout);
     return true;
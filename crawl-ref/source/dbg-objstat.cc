@@ -38,6 +38,7 @@
 #include "state.h"
 #include "stepdown.h"
 #include "stringutil.h"
+#include "tags.h"
 #include "terrain.h"
 #include "version.h"
 
@@ -840,6 +841,172 @@ void objstat_iteration_stats()
     }
 }
 
+// A sharded run has each process write out its records for the parent to
+// fold into its own. Min and max fields combine as such, everything else
+// (including the sums of squares behind the SD fields) just adds up.
+static void _write_stat_map(writer &outf, const map<string, double> &stats)
+{
+    marshallInt(outf, stats.size());
+    for (const auto &stat : stats)
+    {
+        marshallString(outf, stat.first);
+        outf.write(&stat.second, sizeof(stat.second));
+    }
+}
+
+static void _merge_stat_map(reader &inf, map<string, double> &stats)
+{
+    for (int n = unmarshallInt(inf); n > 0; --n)
+    {
+        const string field = unmarshallString(inf);
+        double value;
+        inf.read(&value, sizeof(value));
+
+        auto stat = stats.find(field);
+        if (stat == stats.end())
+            stats[field] = value;
+        else if (ends_with(field, "NumMin"))
+            stat->second = min(stat->second, value);
+        else if (ends_with(field, "NumMax"))
+            stat->second = max(stat->second, value);
+        else
+            stat->second += value;
+    }
+}
+
+static void _write_counts(writer &outf, const vector<int> &counts)
+{
+    marshallInt(outf, counts.size());
+    for (int count : counts)
+        marshallInt(outf, count);
+}
+
+static void _merge_counts(reader &inf, vector<int> &counts)
+{
+    const int n = unmarshallInt(inf);
+    if ((int) counts.size() < n)
+        counts.resize(n);
+    for (int i = 0; i < n; ++i)
+        counts[i] += unmarshallInt(inf);
+}
+
+static void _write_brand_records(writer &outf, const brand_records &brands)
+{
+    marshallInt(outf, brands.size());
+    for (const auto &entry : brands)
+    {
+        marshall_level_id(outf, entry.first);
+        marshallInt(outf, entry.second.size());
+        for (const auto &antiq : entry.second)
+        {
+            marshallInt(outf, antiq.size());
+            for (const auto &counts : antiq)
+                _write_counts(outf, counts);
+        }
+    }
+}
+
+static void _merge_brand_records(reader &inf, brand_records &brands)
+{
+    for (int n = unmarshallInt(inf); n > 0; --n)
+    {
+        auto &types = brands[unmarshall_level_id(inf)];
+        const int ntypes = unmarshallInt(inf);
+        if ((int) types.size() < ntypes)
+            types.resize(ntypes);
+        for (int i = 0; i < ntypes; ++i)
+        {
+            const int nantiq = unmarshallInt(inf);
+            if ((int) types[i].size() < nantiq)
+                types[i].resize(nantiq);
+            for (int j = 0; j < nantiq; ++j)
+                _merge_counts(inf, types[i][j]);
+        }
+    }
+}
+
+void objstat_write_shard(writer &outf)
+{
+    marshallInt(outf, item_recs.size());
+    for (const auto &entry : item_recs)
+    {
+        marshall_level_id(outf, entry.first);
+        marshallInt(outf, entry.second.size());
+        for (const auto &base : entry.second)
+        {
+            marshallInt(outf, base.size());
+            for (const auto &stats : base)
+                _write_stat_map(outf, stats);
+        }
+    }
+
+    _write_brand_records(outf, weapon_brands);
+    _write_brand_records(outf, armour_brands);
+
+    marshallInt(outf, missile_brands.size());
+    for (const auto &entry : missile_brands)
+    {
+        marshall_level_id(outf, entry.first);
+        marshallInt(outf, entry.second.size());
+        for (const auto &counts : entry.second)
+            _write_counts(outf, counts);
+    }
+
+    marshallInt(outf, monster_recs.size());
+    for (const auto &entry : monster_recs)
+    {
+        marshall_level_id(outf, entry.first);
+        marshallInt(outf, entry.second.size());
+        for (const auto &mons : entry.second)
+        {
+            marshallInt(outf, mons.first);
+            _write_stat_map(outf, mons.second);
+        }
+    }
+}
+
+void objstat_merge_shard(reader &inf)
+{
+    for (int n = unmarshallInt(inf); n > 0; --n)
+    {
+        auto &bases = item_recs[unmarshall_level_id(inf)];
+        const int nbases = unmarshallInt(inf);
+        if ((int) bases.size() < nbases)
+            bases.resize(nbases);
+        for (int i = 0; i < nbases; ++i)
+        {
+            const int nsubs = unmarshallInt(inf);
+            if ((int) bases[i].size() < nsubs)
+                bases[i].resize(nsubs);
+            for (int j = 0; j < nsubs; ++j)
+                _merge_stat_map(inf, bases[i][j]);
+        }
+    }
+
+    _merge_brand_records(inf, weapon_brands);
+    _merge_brand_records(inf, armour_brands);
+
+    for (int n = unmarshallInt(inf); n > 0; --n)
+    {
+        auto &types = missile_brands[unmarshall_level_id(inf)];
+        const int ntypes = unmarshallInt(inf);
+        if ((int) types.size() < ntypes)
+            types.resize(ntypes);
+        for (int i = 0; i < ntypes; ++i)
+            _merge_counts(inf, types[i]);
+    }
+
+    for (int n = unmarshallInt(inf); n > 0; --n)
+    {
+        auto &mons = monster_recs[unmarshall_level_id(inf)];
+        for (int m = unmarshallInt(inf); m > 0; --m)
+        {
+            const int mons_ind = unmarshallInt(inf);
+            _merge_stat_map(inf, mons[mons_ind]);
+        }
+    }
+}
+
 static void _write_stat_headers(const vector<string> &fields, bool items = true)
 {
     fprintf(stat_outf, "%s\tLevel", items ? "Item" : "Monster");
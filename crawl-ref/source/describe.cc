@@ -2466,6 +2466,7 @@ void inscribe_item(item_def &item)
     }
 
     item.inscription = new_inscrip;
+    invalidate_autopickup_cache();
 
     mprf_nocap(MSGCH_EQUIPMENT, "%s", item.name(DESC_INVENTORY).c_str());
     you.wield_change  = true;
@@ -60,6 +60,24 @@ DiamondLayout::operator()(const coord_def &p, const uint32_t offset) const
     return ProceduralSample(p, DNGN_FLOOR, offset + 4096);
 }
 
+void ProceduralLayout::sample(const vector<coord_def> &points,
+                              const uint32_t offset,
+                              vector<ProceduralSample> &out) const
+{
+    out.clear();
+    out.reserve(points.size());
+    for (const coord_def &p : points)
+        out.push_back((*this)(p, offset));
+}
+
+ProceduralSample ProceduralLayout::sample_one(const coord_def &p,
+                                              const uint32_t offset) const
+{
+    vector<ProceduralSample> out;
+    sample(vector<coord_def>(1, p), offset, out);
+    return out[0];
+}
+
 static uint32_t _get_changepoint(const worley::noise_datum &n, const double scale)
 {
     return max(1, (int) floor((n.distance[1] - n.distance[0]) * scale) - 5);
@@ -67,25 +85,58 @@ static uint32_t _get_changepoint(const worley::noise_datum &n, const double scal
 
 ProceduralSample
 WorleyLayout::operator()(const coord_def &p, const uint32_t offset) const
+{
+    return sample_one(p, offset);
+}
+
+void WorleyLayout::sample(const vector<coord_def> &points,
+                          const uint32_t offset,
+                          vector<ProceduralSample> &out) const
 {
     const double offset_scale = 5000.0;
-    double x = p.x / scale;
-    double y = p.y / scale;
+    const size_t count = points.size();
+    vector<double> xs(count), ys(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        xs[i] = points[i].x / scale;
+        ys[i] = points[i].y / scale;
+    }
     double z = offset / offset_scale;
-    worley::noise_datum n = worley::noise(x, y, z + seed);
+    vector<worley::noise_datum> noise(count);
+    worley::noise(xs.data(), ys.data(), z + seed, count, noise.data());
 
-    const uint32_t changepoint = offset + _get_changepoint(n, offset_scale);
+    // Hand each sub-layout all of its points at once.
     const uint8_t size = layouts.size();
-    bool parity = n.id[0] % 4;
-    uint32_t id = n.id[0] / 4;
-    const uint8_t choice = parity
-        ? id % size
-        : min(id % size, (id / size) % size);
-    const coord_def pd = p + id;
-    ProceduralSample sample = (*layouts[(choice + seed) % size])(pd, offset);
+    vector<vector<coord_def>> sub_points(size);
+    vector<uint8_t> which(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const worley::noise_datum &n = noise[i];
+        bool parity = n.id[0] % 4;
+        uint32_t id = n.id[0] / 4;
+        const uint8_t choice = parity
+            ? id % size
+            : min(id % size, (id / size) % size);
+        which[i] = (choice + seed) % size;
+        sub_points[which[i]].push_back(points[i] + id);
+    }
+
+    vector<vector<ProceduralSample>> sub_samples(size);
+    for (uint8_t l = 0; l < size; ++l)
+        if (!sub_points[l].empty())
+            layouts[l]->sample(sub_points[l], offset, sub_samples[l]);
 
-    return ProceduralSample(p, sample.feat(),
-                min(changepoint, sample.changepoint()));
+    vector<size_t> next(size, 0);
+    out.clear();
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t changepoint = offset
+                                     + _get_changepoint(noise[i], offset_scale);
+        const ProceduralSample &sample = sub_samples[which[i]][next[which[i]]++];
+        out.emplace_back(points[i], sample.feat(),
+                         min(changepoint, sample.changepoint()));
+    }
 }
 
 ProceduralSample
@@ -100,85 +151,183 @@ ChaosLayout::operator()(const coord_def &p, const uint32_t offset) const
 
 ProceduralSample
 RoilingChaosLayout::operator()(const coord_def &p, const uint32_t offset) const
+{
+    return sample_one(p, offset);
+}
+
+void RoilingChaosLayout::sample(const vector<coord_def> &points,
+                                const uint32_t offset,
+                                vector<ProceduralSample> &out) const
 {
     const double scale = (density - 350) + 4800;
-    double x = p.x;
-    double y = p.y;
+    const size_t count = points.size();
+    vector<double> xs(count), ys(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        xs[i] = points[i].x;
+        ys[i] = points[i].y;
+    }
     double z = offset / scale;
-    worley::noise_datum n = worley::noise(x, y, z);
-    const uint32_t changepoint = offset + _get_changepoint(n, scale);
-    ProceduralSample sample = ChaosLayout(n.id[0] + seed, density)(p, offset);
-    return ProceduralSample(p, sample.feat(), min(sample.changepoint(), changepoint));
+    vector<worley::noise_datum> noise(count);
+    worley::noise(xs.data(), ys.data(), z, count, noise.data());
+
+    out.clear();
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const coord_def &p = points[i];
+        const uint32_t changepoint = offset + _get_changepoint(noise[i], scale);
+        ProceduralSample sample = ChaosLayout(noise[i].id[0] + seed, density)(p, offset);
+        out.emplace_back(p, sample.feat(), min(sample.changepoint(), changepoint));
+    }
 }
 
 ProceduralSample
 WastesLayout::operator()(const coord_def &p, const uint32_t offset) const
 {
-    double x = p.x;
-    double y = p.y;
+    return sample_one(p, offset);
+}
+
+void WastesLayout::sample(const vector<coord_def> &points,
+                          const uint32_t offset,
+                          vector<ProceduralSample> &out) const
+{
+    const size_t count = points.size();
+    vector<double> xs(count), ys(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        xs[i] = points[i].x;
+        ys[i] = points[i].y;
+    }
     double z = offset / 3;
-    worley::noise_datum n = worley::noise(x, y, z);
-    const uint32_t changepoint = offset + _get_changepoint(n, 3);
-    ProceduralSample sample = ChaosLayout(n.id[0], 10)(p, offset);
-    dungeon_feature_type feat = feat_is_solid(sample.feat())
-        ? DNGN_ROCK_WALL : DNGN_FLOOR;
-    return ProceduralSample(p, feat, min(sample.changepoint(), changepoint));
+    vector<worley::noise_datum> noise(count);
+    worley::noise(xs.data(), ys.data(), z, count, noise.data());
+
+    out.clear();
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const coord_def &p = points[i];
+        const uint32_t changepoint = offset + _get_changepoint(noise[i], 3);
+        ProceduralSample sample = ChaosLayout(noise[i].id[0], 10)(p, offset);
+        dungeon_feature_type feat = feat_is_solid(sample.feat())
+            ? DNGN_ROCK_WALL : DNGN_FLOOR;
+        out.emplace_back(p, feat, min(sample.changepoint(), changepoint));
+    }
 }
 
 ProceduralSample
 RiverLayout::operator()(const coord_def &p, const uint32_t offset) const
+{
+    return sample_one(p, offset);
+}
+
+void RiverLayout::sample(const vector<coord_def> &points,
+                         const uint32_t offset,
+                         vector<ProceduralSample> &out) const
 {
     const double scale = 10000;
     const double scalar = 90.0;
-    double x = (p.x + perlin::fBM(p.x/4.0, p.y/4.0, seed, 5) * 3) / scalar;
-    double y = (p.y + perlin::fBM(p.x/4.0 + 3.7, p.y/4.0 + 1.9, seed + 4, 5) * 3) / scalar;
-    worley::noise_datum n = worley::noise(x, y, offset / scale + seed);
-    const uint32_t changepoint = offset + _get_changepoint(n, scale);
-    if ((n.id[0] ^ n.id[1] ^ seed) % 4)
-        return layout(p, offset);
-
-    double delta = n.distance[1] - n.distance[0];
-    if (delta < 1.5/scalar)
+    const size_t count = points.size();
+    vector<double> xs(count), ys(count);
+    for (size_t i = 0; i < count; ++i)
     {
-        dungeon_feature_type feat = DNGN_SHALLOW_WATER;
-        uint64_t hash = hash3(p.x, p.y, n.id[0] + seed);
-        if (!(hash % 5))
-            feat = DNGN_DEEP_WATER;
-        if (!(hash % 23))
-            feat = DNGN_TREE;
-        return ProceduralSample(p, feat, changepoint);
+        const coord_def &p = points[i];
+        xs[i] = (p.x + perlin::fBM(p.x/4.0, p.y/4.0, seed, 5) * 3) / scalar;
+        ys[i] = (p.y + perlin::fBM(p.x/4.0 + 3.7, p.y/4.0 + 1.9, seed + 4, 5) * 3) / scalar;
+    }
+    vector<worley::noise_datum> noise(count);
+    worley::noise(xs.data(), ys.data(), offset / scale + seed, count,
+                  noise.data());
+
+    // Points away from the rivers fall through to the underlying layout,
+    // which samples them all together.
+    vector<dungeon_feature_type> feats(count, DNGN_UNSEEN);
+    vector<coord_def> rest;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const coord_def &p = points[i];
+        const worley::noise_datum &n = noise[i];
+        if (!((n.id[0] ^ n.id[1] ^ seed) % 4)
+            && n.distance[1] - n.distance[0] < 1.5/scalar)
+        {
+            feats[i] = DNGN_SHALLOW_WATER;
+            uint64_t hash = hash3(p.x, p.y, n.id[0] + seed);
+            if (!(hash % 5))
+                feats[i] = DNGN_DEEP_WATER;
+            if (!(hash % 23))
+                feats[i] = DNGN_TREE;
+        }
+        else
+            rest.push_back(p);
+    }
+
+    vector<ProceduralSample> rest_samples;
+    if (!rest.empty())
+        layout.sample(rest, offset, rest_samples);
+
+    size_t next = 0;
+    out.clear();
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (feats[i] == DNGN_UNSEEN)
+            out.push_back(rest_samples[next++]);
+        else
+        {
+            out.emplace_back(points[i], feats[i],
+                             offset + _get_changepoint(noise[i], scale));
+        }
     }
-    return layout(p, offset);
 }
 
 ProceduralSample
 NewAbyssLayout::operator()(const coord_def &p, const uint32_t offset) const
+{
+    return sample_one(p, offset);
+}
+
+void NewAbyssLayout::sample(const vector<coord_def> &points,
+                            const uint32_t offset,
+                            vector<ProceduralSample> &out) const
 {
     const double scale = 1.0 / 3.2;
-    uint64_t base = hash3(p.x, p.y, seed);
-    worley::noise_datum noise = worley::noise(
-            p.x * scale,
-            p.y * scale,
-            offset / 1000.0);
-    dungeon_feature_type feat = DNGN_FLOOR;
+    const size_t count = points.size();
+    vector<double> xs(count), ys(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        xs[i] = points[i].x * scale;
+        ys[i] = points[i].y * scale;
+    }
+    vector<worley::noise_datum> noise(count);
+    worley::noise(xs.data(), ys.data(), offset / 1000.0, count, noise.data());
 
-    int dist = noise.distance[0] * 100;
-    bool isWall = (dist > 118 || dist < 30);
-    int delta = min(abs(dist - 118), abs(30 - dist));
+    out.clear();
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const coord_def &p = points[i];
+        uint64_t base = hash3(p.x, p.y, seed);
+        dungeon_feature_type feat = DNGN_FLOOR;
 
-    if ((noise.id[0] + noise.id[1]) % 6 == 0)
-        isWall = false;
+        int dist = noise[i].distance[0] * 100;
+        bool isWall = (dist > 118 || dist < 30);
+        int delta = min(abs(dist - 118), abs(30 - dist));
 
-    if (base % 3 == 0)
-        isWall = !isWall;
+        if ((noise[i].id[0] + noise[i].id[1]) % 6 == 0)
+            isWall = false;
 
-    if (isWall)
-    {
-        int fuzz = (base / 3) % 3 ? 0 : (base / 9) % 3 - 1;
-        feat = _pick_pseudorandom_wall(noise.id[0] + fuzz);
-    }
+        if (base % 3 == 0)
+            isWall = !isWall;
 
-    return ProceduralSample(p, feat, offset + delta);
+        if (isWall)
+        {
+            int fuzz = (base / 3) % 3 ? 0 : (base / 9) % 3 - 1;
+            feat = _pick_pseudorandom_wall(noise[i].id[0] + fuzz);
+        }
+
+        out.emplace_back(p, feat, offset + delta);
+    }
 }
 
 dungeon_feature_type sanitize_feature(dungeon_feature_type feature, bool strict)
@@ -266,11 +415,37 @@ LevelLayout::LevelLayout(level_id id, uint32_t _seed, const ProceduralLayout &_l
 ProceduralSample
 LevelLayout::operator()(const coord_def &p, const uint32_t offset) const
 {
-    coord_def cp = clip(p);
-    dungeon_feature_type feat = grid(cp);
-    if (feat == DNGN_UNSEEN)
-        return layout(p, offset);
-    return ProceduralSample(p, feat, offset + 4096);
+    return sample_one(p, offset);
+}
+
+void LevelLayout::sample(const vector<coord_def> &points,
+                         const uint32_t offset,
+                         vector<ProceduralSample> &out) const
+{
+    const size_t count = points.size();
+    vector<dungeon_feature_type> feats(count);
+    vector<coord_def> rest;
+    for (size_t i = 0; i < count; ++i)
+    {
+        feats[i] = grid(clip(points[i]));
+        if (feats[i] == DNGN_UNSEEN)
+            rest.push_back(points[i]);
+    }
+
+    vector<ProceduralSample> rest_samples;
+    if (!rest.empty())
+        layout.sample(rest, offset, rest_samples);
+
+    size_t next = 0;
+    out.clear();
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (feats[i] == DNGN_UNSEEN)
+            out.push_back(rest_samples[next++]);
+        else
+            out.emplace_back(points[i], feats[i], offset + 4096);
+    }
 }
 
 ProceduralSample
@@ -55,7 +55,16 @@ class ProceduralLayout
     public:
         virtual ProceduralSample operator()(const coord_def &p,
             const uint32_t offset = 0) const = 0;
+        // Sample every point at the same offset, in order. The results are
+        // identical to calling operator() on each point. Layouts built on
+        // noise override this to compute the noise of all the points in one
+        // pass, and implement operator() with sample_one().
+        virtual void sample(const vector<coord_def> &points,
+            const uint32_t offset, vector<ProceduralSample> &out) const;
         virtual ~ProceduralLayout() { }
+    protected:
+        ProceduralSample sample_one(const coord_def &p,
+            const uint32_t offset) const;
 };
 
 // Geometric layout that generates columns with width cw, col spacing cs, row width rw, and row spacing rs.
@@ -98,6 +107,8 @@ class WorleyLayout : public ProceduralLayout
             seed(_seed), layouts(_layouts), scale(_scale) {}
         ProceduralSample operator()(const coord_def &p,
             const uint32_t offset = 0) const override;
+        void sample(const vector<coord_def> &points, const uint32_t offset,
+            vector<ProceduralSample> &out) const override;
     private:
         const uint32_t seed;
         const vector<const ProceduralLayout*> layouts;
@@ -130,6 +141,8 @@ class RoilingChaosLayout : public ProceduralLayout
             seed(_seed), density(_density) {}
         ProceduralSample operator()(const coord_def &p,
             const uint32_t offset = 0) const override;
+        void sample(const vector<coord_def> &points, const uint32_t offset,
+            vector<ProceduralSample> &out) const override;
     private:
         const uint32_t seed;
         const uint32_t density;
@@ -142,6 +155,8 @@ class WastesLayout : public ProceduralLayout
         WastesLayout() { };
         ProceduralSample operator()(const coord_def &p,
             const uint32_t offset = 0) const override;
+        void sample(const vector<coord_def> &points, const uint32_t offset,
+            vector<ProceduralSample> &out) const override;
 };
 
 class RiverLayout : public ProceduralLayout
@@ -151,6 +166,8 @@ class RiverLayout : public ProceduralLayout
             seed(_seed), layout(_layout) {}
         ProceduralSample operator()(const coord_def &p,
             const uint32_t offset = 0) const override;
+        void sample(const vector<coord_def> &points, const uint32_t offset,
+            vector<ProceduralSample> &out) const override;
     private:
         const uint32_t seed;
         const ProceduralLayout &layout;
@@ -163,6 +180,8 @@ class NewAbyssLayout : public ProceduralLayout
         NewAbyssLayout(uint32_t _seed) : seed(_seed) {}
         ProceduralSample operator()(const coord_def &p,
             const uint32_t offset = 0) const override;
+        void sample(const vector<coord_def> &points, const uint32_t offset,
+            vector<ProceduralSample> &out) const override;
     private:
         const uint32_t seed;
 };
@@ -176,6 +195,8 @@ class LevelLayout : public ProceduralLayout
             const ProceduralLayout &_layout);
         ProceduralSample operator()(const coord_def &p,
             const uint32_t offset = 0) const override;
+        void sample(const vector<coord_def> &points, const uint32_t offset,
+            vector<ProceduralSample> &out) const override;
     private:
         feature_grid grid;
         uint32_t seed;
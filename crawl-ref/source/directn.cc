@@ -1286,7 +1286,7 @@ bool direction_chooser::select(bool allow_out_of_range, bool endpoint)
 
 bool direction_chooser::pickup_item()
 {
-    item_info *ii = 0;
+    const item_info *ii = 0;
     if (in_bounds(target()))
         ii = env.map_knowledge(target()).item();
     if (!ii || !ii->is_valid(true))
@@ -1294,7 +1294,10 @@ bool direction_chooser::pickup_item()
         mprf(MSGCH_EXAMINE_FILTER, "You can't see any item there.");
         return false;
     }
-    ii->flags |= ISFLAG_THROWN; // make autoexplore greedy
+    item_info marked = *ii;
+    marked.flags |= ISFLAG_THROWN; // make autoexplore greedy
+    env.map_knowledge(target()).replace_item(marked);
+    ii = env.map_knowledge(target()).item();
 
     // From this point, if there's no item, we'll fake one. False info means
     // it's out of bounds and taken, or a mimic.
@@ -2119,10 +2122,11 @@ void full_describe_square(const coord_def &c, bool cleanup)
         // First priority: monsters.
         describe_monsters(*mi);
     }
-    else if (item_info *obj = env.map_knowledge(c).item())
+    else if (const item_info *obj = env.map_knowledge(c).item())
     {
         // Second priority: objects.
-        describe_item(*obj);
+        item_info copy = *obj;
+        describe_item(copy);
     }
     else
     {
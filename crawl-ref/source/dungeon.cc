@@ -70,6 +70,7 @@
 #include "tileview.h"
 #include "timed_effects.h"
 #include "traps.h"
+#include "travel.h"
 
 #ifdef DEBUG_DIAGNOSTICS
 #define DEBUG_TEMPLES
@@ -1167,6 +1168,7 @@ void dgn_reset_level(bool enable_random_maps)
     // Initialise all items.
     for (int i = 0; i < MAX_ITEMS; i++)
         init_item(i);
+    rebuild_free_item_slots();
 
     // Reset all monsters.
     reset_all_monsters();
@@ -4197,6 +4199,7 @@ static int _dgn_item_corpse(const item_spec &ispec, const coord_def where)
         if (!mon)
             continue;
         mon->position = where;
+        monster_index_update(*mon);
         corpse = place_monster_corpse(*mon, true, true);
         // Dismiss the monster we used to place the corpse.
         mon->flags |= MF_HARD_RESET;
@@ -5093,6 +5096,7 @@ void dgn_replace_area(const coord_def& p1, const coord_def& p2,
             {
                 env.map_knowledge(*ri).set_feature(feature, 0,
                                                    get_trap_type(*ri));
+                update_travel_region_cell(*ri);
 #ifdef USE_TILE
                 env.tile_bk_bg(*ri) = feature;
 #endif
@@ -52,15 +52,14 @@ static bool _need_auto_exclude(const monster* mon, bool sleepy = false)
                                            && testbits(mon->flags, MF_SEEN));
     lowercase(name);
 
-    for (const text_pattern &pat : Options.auto_exclude)
+    static pattern_set auto_exclude;
+    auto_exclude.set_patterns(Options.auto_exclude);
+    if (auto_exclude.matches(name)
+        && _mon_needs_auto_exclude(mon, sleepy)
+        && (mon->attitude == ATT_HOSTILE
+            || mon->type == MONS_HYPERACTIVE_BALLISTOMYCETE))
     {
-        if (pat.matches(name)
-            && _mon_needs_auto_exclude(mon, sleepy)
-            && (mon->attitude == ATT_HOSTILE
-                || mon->type == MONS_HYPERACTIVE_BALLISTOMYCETE))
-        {
-            return true;
-        }
+        return true;
     }
 
     return false;
@@ -379,6 +378,7 @@ static void _exclude_update()
 {
     set_level_exclusion_annotation(curr_excludes.get_exclusion_desc());
     travel_cache.update_excludes();
+    invalidate_travel_regions();
 }
 
 static void _exclude_update(const coord_def &p)
@@ -572,11 +572,19 @@ struct item_def
 
     CrawlHashTable props;
 
+    /// The last autopickup decision the options and hooks made for this
+    /// item, good while autopickup_epoch and autopickup_key still match;
+    /// see items.cc.
+    mutable unsigned int autopickup_epoch;
+    mutable uint32_t     autopickup_key;
+    mutable bool         autopickup;
+
 public:
     item_def() : base_type(OBJ_UNASSIGNED), sub_type(0), plus(0), plus2(0),
                  special(0), rnd(0), quantity(0), flags(0),
                  pos(), link(NON_ITEM), slot(0), orig_place(),
-                 orig_monnum(0), inscription()
+                 orig_monnum(0), inscription(), autopickup_epoch(0),
+                 autopickup_key(0), autopickup(false)
     {
     }
 
@@ -740,15 +740,19 @@ static void _write_ghost_version(writer &outf)
         marshallInt(outf, 0);
 }
 
+// Snapshot the chunk into memory; compressing and writing it out is left
+// to package::flush_async(), or whatever touches the save next.
 static void _write_tagged_chunk(const string &chunkname, tag_type tag)
 {
-    writer outf(you.save, chunkname);
+    vector<unsigned char> buf;
+    writer outf(&buf);
 
     // write version
     marshallUByte(outf, TAG_MAJOR_VERSION);
     marshallUByte(outf, TAG_MINOR_VERSION);
 
     tag_write(tag, outf);
+    you.save->write_async(chunkname, buf);
 }
 
 static int _get_dest_stair_type(branch_type old_branch,
@@ -1210,6 +1214,10 @@ bool load_level(dungeon_feature_type stair_taken, load_mode_type load_mode,
     // Did we get here by popping the level stack?
     bool popped = false;
 
+    // Look for the destination before the old level is saved, so that the
+    // save can run in the background while a new level is generated.
+    bool level_exists = you.save->has_chunk(level_name);
+
     coord_def return_pos; //TODO: initialize to null
     if (load_mode != LOAD_VISITOR)
         popped = _leave_level(stair_taken, old_level, &return_pos);
@@ -1248,9 +1256,17 @@ bool load_level(dungeon_feature_type stair_taken, load_mode_type load_mode,
             _grab_followers();
 
             if (env.level_state & LSTATE_DELETED)
+            {
                 delete_level(old_level), dprf("<lightmagenta>Deleting level.</lightmagenta>");
+                level_exists = you.save->has_chunk(level_name);
+            }
             else
+            {
                 _save_level(old_level);
+                you.save->flush_async();
+                if (old_level.describe() == level_name)
+                    level_exists = true;
+            }
         }
 
         // The player is now between levels.
@@ -1273,7 +1289,7 @@ bool load_level(dungeon_feature_type stair_taken, load_mode_type load_mode,
     bool just_created_level = false;
 
     // GENERATE new level when the file can't be opened:
-    if (!you.save->has_chunk(level_name))
+    if (!level_exists)
     {
         ASSERT(load_mode != LOAD_VISITOR);
         dprf("Generating new level for '%s'.", level_name.c_str());
@@ -1509,11 +1525,13 @@ static void _save_level(const level_id& lid)
 # define CHUNK(short, long) long
 #endif
 
-#define SAVEFILE(short, long, savefn)           \
-    do                                          \
-    {                                           \
-        writer w(you.save, CHUNK(short, long)); \
-        savefn(w);                              \
+#define SAVEFILE(short, long, savefn)                   \
+    do                                                  \
+    {                                                   \
+        vector<unsigned char> buf;                      \
+        writer w(&buf);                                 \
+        savefn(w);                                      \
+        you.save->write_async(CHUNK(short, long), buf); \
     } while (false)
 
 // Stack allocated string's go in separate function, so Valgrind doesn't
@@ -1613,6 +1631,8 @@ void save_game(bool leave_game, const char *farewellmsg)
     {
         if (!crawl_state.disables[DIS_SAVE_CHECKPOINTS])
             you.save->commit();
+        else
+            you.save->flush_async();
         return;
     }
 
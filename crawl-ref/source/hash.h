@@ -16,6 +16,16 @@ static inline uint64_t hash3(uint64_t x, uint64_t y, uint64_t z)
     return x;
 }
 
+// 32 bit FNV-1a over a sequence of values, for cache keys and the like.
+class fnv_hash32
+{
+public:
+    void mix(uint32_t val) { hash = (hash ^ val) * 16777619U; }
+    uint32_t value() const { return hash; }
+private:
+    uint32_t hash = 2166136261U;
+};
+
 uint32_t hash32(const void *data, int len) PURE;
 unsigned int hash_rand(int x, uint32_t seed, uint32_t id = 0);
 
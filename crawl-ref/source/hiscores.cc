@@ -47,6 +47,7 @@
 #include "state.h"
 #include "status.h"
 #include "stringutil.h"
+#include "syscalls.h"
 #ifdef USE_TILE
  #include "tilepick.h"
 #endif
@@ -69,6 +70,11 @@ static time_t _parse_time(const string &st);
 static string _xlog_escape(const string &s);
 static string _xlog_unescape(const string &s);
 static vector<string> _xlog_split_fields(const string &s);
+#ifdef SCORE_FILE_INDEXED
+static int _hs_new_indexed_entry(const string &scorefile,
+                                 const scorefile_entry &ne);
+static int _hs_read_indexed(const string &scorefile, int max);
+#endif
 
 static string _score_file_name()
 {
@@ -94,6 +100,9 @@ int hiscores_new_entry(const scorefile_entry &ne)
 {
     unwind_bool score_update(crawl_state.updating_scores, true);
 
+#ifdef SCORE_FILE_INDEXED
+    return _hs_new_indexed_entry(_score_file_name(), ne);
+#else
     FILE *scores;
     int i, total_entries;
     bool inserted = false;
@@ -173,6 +182,7 @@ int hiscores_new_entry(const scorefile_entry &ne)
     // close scorefile.
     _hs_close(scores, _score_file_name());
     return newest_entry;
+#endif
 }
 
 void logfile_new_entry(const scorefile_entry &ne)
@@ -222,6 +232,24 @@ void hiscores_print_all(int display_count, int format)
 {
     unwind_bool scorefile_display(crawl_state.updating_scores, true);
 
+#ifdef SCORE_FILE_INDEXED
+    const int max = display_count <= 0 ? SCORE_FILE_ENTRIES
+                                       : min(display_count, SCORE_FILE_ENTRIES);
+    const int indexed = _hs_read_indexed(_score_file_name(), max);
+    if (indexed >= 0)
+    {
+        for (int entry = 0; entry < indexed; ++entry)
+        {
+            if (format == -1)
+                printf("%s", hs_list[entry]->raw_string().c_str());
+            else
+                _hiscores_print_entry(*hs_list[entry], entry, format, printf);
+            hs_list[entry].reset(nullptr);
+        }
+        return;
+    }
+#endif
+
     FILE *scores = _hs_open("r", _score_file_name());
     if (scores == nullptr)
     {
@@ -245,34 +273,45 @@ void hiscores_print_all(int display_count, int format)
     _hs_close(scores, _score_file_name());
 }
 
-// Displays high scores using curses. For output to the console, use
-// hiscores_print_all.
-void hiscores_print_list(int display_count, int format, int newest_entry)
+// Reads the score table into hs_list, best first. Returns the number of
+// entries read, or -1 if there is no score table yet.
+static int _hs_read_list()
 {
-    unwind_bool scorefile_display(crawl_state.updating_scores, true);
-
-    FILE *scores;
-    int i, total_entries;
-
-    if (display_count <= 0)
-        return;
+#ifdef SCORE_FILE_INDEXED
+    const int indexed = _hs_read_indexed(_score_file_name(),
+                                         SCORE_FILE_ENTRIES);
+    if (indexed >= 0)
+        return indexed;
+#endif
 
-    // open highscore file (reading)
-    scores = _hs_open("r", _score_file_name());
+    FILE *scores = _hs_open("r", _score_file_name());
     if (scores == nullptr)
-        return;
+        return -1;
 
-    // read highscore file
+    int i;
     for (i = 0; i < SCORE_FILE_ENTRIES; i++)
     {
         hs_list[i].reset(new scorefile_entry);
         if (_hs_read(scores, *hs_list[i]) == false)
             break;
     }
-    total_entries = i;
 
-    // close off
     _hs_close(scores, _score_file_name());
+    return i;
+}
+
+// Displays high scores using curses. For output to the console, use
+// hiscores_print_all.
+void hiscores_print_list(int display_count, int format, int newest_entry)
+{
+    unwind_bool scorefile_display(crawl_state.updating_scores, true);
+
+    if (display_count <= 0)
+        return;
+
+    const int total_entries = _hs_read_list();
+    if (total_entries < 0)
+        return;
 
     textcolour(LIGHTGREY);
 
@@ -286,7 +325,7 @@ void hiscores_print_list(int display_count, int format, int newest_entry)
 
     const int finish = start + display_count;
 
-    for (i = start; i < finish && i < total_entries; i++)
+    for (int i = start; i < finish && i < total_entries; i++)
     {
         // check for recently added entry
         if (i == newest_entry)
@@ -321,23 +360,9 @@ static void _add_hiscore_row(MenuScroller* scroller, scorefile_entry& se, int id
 
 static void _construct_hiscore_table(MenuScroller* scroller)
 {
-    FILE *scores = _hs_open("r", _score_file_name());
+    const int total_entries = _hs_read_list();
 
-    if (scores == nullptr)
-        return;
-
-    int i;
-    // read highscore file
-    for (i = 0; i < SCORE_FILE_ENTRIES; i++)
-    {
-        hs_list[i].reset(new scorefile_entry);
-        if (_hs_read(scores, *hs_list[i]) == false)
-            break;
-    }
-
-    _hs_close(scores, _score_file_name());
-
-    for (int j=0; j<i; j++)
+    for (int j = 0; j < total_entries; j++)
         _add_hiscore_row(scroller, *hs_list[j], j);
 }
 
@@ -608,6 +633,331 @@ static void _hs_write(FILE *scores, scorefile_entry &se)
     fprintf(scores, "%s", se.raw_string().c_str());
 }
 
+#ifdef SCORE_FILE_INDEXED
+// The indexed store keeps the xlog lines of the score table in an
+// append-only log, and their ranking in a separate index of fixed-size
+// records. The index is small (16 bytes per entry), so a new game end only
+// has to binary search it, append its line to the log and rewrite the
+// index; entries that fall off the table stay in the log until most of it
+// is dead, when it is compacted into a new generation of the log. Writers
+// and readers hold a separate lock file, since the index itself is
+// replaced rather than rewritten.
+//
+// Index layout: an 8 byte magic string, the generation of the log and the
+// number of lines in it as little-endian 64 bit integers, then one record
+// per entry, best first, each a 64 bit score and a 64 bit offset into the
+// log.
+//
+// The index is the commit point: it is always written to a temporary
+// file, synced and renamed into place, and only ever refers to log data
+// that has already been synced. A crash at any point leaves either the
+// old index and the log it refers to, or the new ones.
+
+static const char SCORE_INDEX_MAGIC[] = "CRSIDX02";
+static const size_t SCORE_INDEX_FIELD = 8;
+static const size_t SCORE_INDEX_HEADER = 3 * SCORE_INDEX_FIELD;
+
+struct score_index_record
+{
+    int64_t score;
+    int64_t offset;
+};
+
+struct score_index
+{
+    int64_t log_gen = 0;       // Which log file the offsets refer to.
+    int64_t log_entries = 0;   // Lines in the log, live or dead.
+    vector<score_index_record> records;
+};
+
+static string _score_index_name(const string &scorefile)
+{
+    return scorefile + ".idx";
+}
+
+static string _score_lock_name(const string &scorefile)
+{
+    return scorefile + ".lock";
+}
+
+static string _score_log_name(const string &scorefile, int64_t gen)
+{
+    return make_stringf("%s.xlog.%" PRId64, scorefile.c_str(), gen);
+}
+
+static void _put_int64(string &buf, int64_t val)
+{
+    const uint64_t bits = static_cast<uint64_t>(val);
+    for (size_t i = 0; i < SCORE_INDEX_FIELD; ++i)
+        buf += static_cast<char>((bits >> (8 * i)) & 0xff);
+}
+
+static int64_t _get_int64(const char *p)
+{
+    uint64_t bits = 0;
+    for (size_t i = SCORE_INDEX_FIELD; i > 0; --i)
+        bits = (bits << 8) | static_cast<unsigned char>(p[i - 1]);
+    return static_cast<int64_t>(bits);
+}
+
+// Flushes a file all the way to the disk. Unlike saves, this is done even
+// on servers: it happens once per game, and a torn index would lose the
+// whole score table.
+static bool _sync_score_file(FILE *handle)
+{
+    return fflush(handle) == 0 && fdatasync(fileno(handle)) == 0;
+}
+
+// A missing or unrecognised index reads as an empty store.
+static score_index _read_score_index(const string &idxname)
+{
+    score_index idx;
+    FILE *handle = fopen_u(idxname.c_str(), "rb");
+    if (!handle)
+        return idx;
+
+    string buf;
+    char chunk[4096];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof chunk, handle)) > 0)
+        buf.append(chunk, got);
+    fclose(handle);
+
+    if (buf.size() < SCORE_INDEX_HEADER
+        || buf.compare(0, SCORE_INDEX_FIELD, SCORE_INDEX_MAGIC) != 0)
+    {
+        return idx;
+    }
+
+    idx.log_gen = _get_int64(&buf[SCORE_INDEX_FIELD]);
+    idx.log_entries = _get_int64(&buf[2 * SCORE_INDEX_FIELD]);
+    for (size_t pos = SCORE_INDEX_HEADER;
+         pos + 2 * SCORE_INDEX_FIELD <= buf.size();
+         pos += 2 * SCORE_INDEX_FIELD)
+    {
+        idx.records.push_back({_get_int64(&buf[pos]),
+                               _get_int64(&buf[pos + SCORE_INDEX_FIELD])});
+    }
+
+    return idx;
+}
+
+// Writes buf to a temporary file, syncs it and renames it over name.
+static bool _replace_score_file(const string &name, const string &buf)
+{
+    const string tmpname = name + ".tmp";
+    FILE *out = fopen_u(tmpname.c_str(), "wb");
+    if (!out)
+        return false;
+
+    const bool written = fwrite(buf.data(), 1, buf.size(), out) == buf.size()
+                         && _sync_score_file(out);
+    if (fclose(out) != 0 || !written
+        || rename_u(tmpname.c_str(), name.c_str()) != 0)
+    {
+        unlink_u(tmpname.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool _write_score_index(const string &idxname, const score_index &idx)
+{
+    string buf = SCORE_INDEX_MAGIC;
+    _put_int64(buf, idx.log_gen);
+    _put_int64(buf, idx.log_entries);
+    for (const score_index_record &rec : idx.records)
+    {
+        _put_int64(buf, rec.score);
+        _put_int64(buf, rec.offset);
+    }
+
+    return _replace_score_file(idxname, buf);
+}
+
+// The position a new entry takes: ahead of every entry it ties or beats,
+// as in the classic score file.
+static int _score_index_rank(const score_index &idx, int64_t score)
+{
+    auto pos = lower_bound(idx.records.begin(), idx.records.end(), score,
+                           [](const score_index_record &rec, int64_t val)
+                           { return rec.score > val; });
+    return pos - idx.records.begin();
+}
+
+// Fails if the line at the record's offset is not the entry it indexes.
+static bool _read_score_log_entry(FILE *log, const score_index_record &rec,
+                                  scorefile_entry &dest)
+{
+    return fseek(log, rec.offset, SEEK_SET) == 0
+           && _hs_read(log, dest)
+           && dest.get_score() == rec.score;
+}
+
+// Returns the offset of the appended line, or -1 on failure.
+static int64_t _append_score_log_entry(FILE *log, const scorefile_entry &se)
+{
+    if (fseek(log, 0, SEEK_END) != 0)
+        return -1;
+
+    const long offset = ftell(log);
+    if (offset < 0 || fprintf(log, "%s", se.raw_string().c_str()) < 0)
+        return -1;
+
+    return offset;
+}
+
+// Copies the entries of a classic score file into a new store. The score
+// file itself is left alone.
+static bool _import_score_file(const string &scorefile, FILE *log,
+                               score_index &idx)
+{
+    FILE *scores = _hs_open("r", scorefile);
+    if (scores == nullptr)
+        return false;
+
+    scorefile_entry se;
+    while (idx.records.size() < SCORE_FILE_ENTRIES && _hs_read(scores, se))
+    {
+        const int64_t offset = _append_score_log_entry(log, se);
+        if (offset < 0)
+            break;
+
+        idx.records.push_back({se.get_score(), offset});
+        idx.log_entries++;
+    }
+
+    _hs_close(scores, scorefile);
+    return !idx.records.empty();
+}
+
+// Writes the entries the index refers to into the next generation of the
+// log, and points the index at it. Only the caller's write of the index
+// commits the new generation; until then, the old log is still in use.
+static bool _compact_score_log(const string &scorefile, score_index &idx)
+{
+    FILE *log = fopen_u(_score_log_name(scorefile, idx.log_gen).c_str(), "rb");
+    if (!log)
+        return false;
+
+    string lines;
+    vector<score_index_record> kept;
+    for (const score_index_record &rec : idx.records)
+    {
+        scorefile_entry se;
+        if (!_read_score_log_entry(log, rec, se))
+            continue;
+
+        kept.push_back({rec.score, static_cast<int64_t>(lines.size())});
+        lines += se.raw_string();
+    }
+    fclose(log);
+
+    if (!_replace_score_file(_score_log_name(scorefile, idx.log_gen + 1),
+                             lines))
+    {
+        return false;
+    }
+
+    idx.log_gen++;
+    idx.records = move(kept);
+    idx.log_entries = idx.records.size();
+    return true;
+}
+
+static int _hs_new_indexed_entry(const string &scorefile,
+                                 const scorefile_entry &ne)
+{
+    const string idxname = _score_index_name(scorefile);
+
+    // a+ for an exclusive lock, and to create the lock file if needed.
+    file_lock lock(_score_lock_name(scorefile), "a+");
+
+    // Only a store that doesn't exist yet imports the classic score file;
+    // an empty one has simply had nothing written to it.
+    const bool fresh = !file_exists(idxname);
+    score_index idx = _read_score_index(idxname);
+    const string logname = _score_log_name(scorefile, idx.log_gen);
+
+    FILE *log = fopen_u(logname.c_str(), "ab");
+    if (log == nullptr)
+        end(1, true, "failed to open score log for writing");
+
+    bool changed = fresh;
+    if (fresh)
+        _import_score_file(scorefile, log, idx);
+
+    int newest_entry = _score_index_rank(idx, ne.get_score());
+    if (newest_entry < SCORE_FILE_ENTRIES)
+    {
+        const int64_t offset = _append_score_log_entry(log, ne);
+        if (offset < 0)
+            end(1, true, "unable to write score log");
+
+        idx.records.insert(idx.records.begin() + newest_entry,
+                           {ne.get_score(), offset});
+        if (idx.records.size() > SCORE_FILE_ENTRIES)
+            idx.records.resize(SCORE_FILE_ENTRIES);
+        idx.log_entries++;
+        changed = true;
+    }
+    else
+        newest_entry = -1;
+
+    // The lines must be on disk before an index that refers to them.
+    const bool synced = _sync_score_file(log);
+    if (fclose(log) != 0 || !synced)
+        end(1, true, "unable to write score log");
+
+    if (changed)
+    {
+        const int64_t live = idx.records.size();
+        const int64_t old_gen = idx.log_gen;
+        if (idx.log_entries - live > live)
+            _compact_score_log(scorefile, idx);
+
+        if (!_write_score_index(idxname, idx))
+            end(1, true, "unable to write score index");
+
+        if (idx.log_gen != old_gen)
+            unlink_u(logname.c_str());
+    }
+
+    return newest_entry;
+}
+
+// Reads up to max entries of the indexed store into hs_list, best first.
+// Returns the number read, or -1 if there is no store for this score file.
+static int _hs_read_indexed(const string &scorefile, int max)
+{
+    const string idxname = _score_index_name(scorefile);
+    if (scorefile == "-" || !file_exists(idxname))
+        return -1;
+
+    // A shared lock keeps a compaction from removing the log under us.
+    file_lock lock(_score_lock_name(scorefile), "r", false);
+
+    const score_index idx = _read_score_index(idxname);
+    int count = 0;
+    const string logname = _score_log_name(scorefile, idx.log_gen);
+    if (FILE *log = fopen_u(logname.c_str(), "rb"))
+    {
+        for (const score_index_record &rec : idx.records)
+        {
+            if (count >= max)
+                break;
+
+            hs_list[count].reset(new scorefile_entry);
+            if (_read_score_log_entry(log, rec, *hs_list[count]))
+                count++;
+        }
+        fclose(log);
+    }
+
+    return count;
+}
+#endif
+
 static const char *kill_method_names[] =
 {
     "mon", "pois", "cloud", "beam", "lava", "water",
@@ -254,6 +254,7 @@ const vector<GameOption*> game_options::build_options_list()
         new IntGameOption(SIMPLE_NAME(explore_wall_bias), 0, 0, 1000),
         new IntGameOption(SIMPLE_NAME(scroll_margin_x), 2, 0),
         new IntGameOption(SIMPLE_NAME(scroll_margin_y), 2, 0),
+        new IntGameOption(SIMPLE_NAME(map_cache_size), 16, 0, 1024),
         new IntGameOption(SIMPLE_NAME(item_stack_summary_minimum), 4),
         new IntGameOption(SIMPLE_NAME(level_map_cursor_step), 7, 1, 50),
         new IntGameOption(SIMPLE_NAME(dump_item_origin_price), -1, -1),
@@ -351,6 +352,7 @@ const vector<GameOption*> game_options::build_options_list()
         new BoolGameOption(SIMPLE_NAME(tile_realtime_anim), false),
         new BoolGameOption(SIMPLE_NAME(tile_level_map_hide_messages), true),
         new BoolGameOption(SIMPLE_NAME(tile_level_map_hide_sidebar), false),
+        new BoolGameOption(SIMPLE_NAME(tile_binary_map), false),
         new StringGameOption(SIMPLE_NAME(tile_font_crt_family), "monospace"),
         new StringGameOption(SIMPLE_NAME(tile_font_msg_family), "monospace"),
         new StringGameOption(SIMPLE_NAME(tile_font_stat_family), "monospace"),
@@ -936,6 +938,7 @@ void game_options::reset_options()
     options_by_name = build_options_map(option_behaviour);
     for (GameOption* option : option_behaviour)
         option->reset();
+    invalidate_autopickup_cache();
 
     filename     = "unknown";
     basefilename = "unknown";
@@ -2393,6 +2396,9 @@ void game_options::read_option_line(const string &str, bool runscript)
     if (first_equals < 0)
         return;
 
+    // Any option may feed the autopickup checks, directly or through Lua.
+    invalidate_autopickup_cache();
+
     field = str.substr(first_equals + 1);
     field = expand_vars(field);
 
@@ -3671,6 +3677,7 @@ enum commandline_option_type
     CLO_MAPSTAT,
     CLO_OBJSTAT,
     CLO_ITERATIONS,
+    CLO_JOBS,
     CLO_ARENA,
     CLO_DUMP_MAPS,
     CLO_TEST,
@@ -3708,7 +3715,8 @@ static const char *cmd_ops[] =
 {
     "scores", "name", "species", "background", "dir", "rc",
     "rcdir", "tscores", "vscores", "scorefile", "morgue", "macro",
-    "mapstat", "objstat", "iters", "arena", "dump-maps", "test", "script",
+    "mapstat", "objstat", "iters", "jobs", "arena", "dump-maps", "test",
+    "script",
     "builddb", "help", "version", "seed", "save-version", "sprint",
     "extra-opt-first", "extra-opt-last", "sprint-map", "edit-save",
     "print-charset", "tutorial", "wizard", "explore", "no-save",
@@ -4143,6 +4151,7 @@ bool parse_args(int argc, char **argv, bool rc_only)
 
     SysEnv.rcdirs.clear();
     SysEnv.map_gen_iters = 0;
+    SysEnv.map_gen_jobs = 1;
 
     if (argc < 2)           // no args!
         return true;
@@ -4322,6 +4331,29 @@ bool parse_args(int argc, char **argv, bool rc_only)
 #endif
             break;
 
+        case CLO_JOBS:
+#ifdef DEBUG_STATISTICS
+            if (!next_is_param || !isadigit(*next_arg))
+            {
+                fprintf(stderr, "Integer argument required for -%s\n", arg);
+                end(1);
+            }
+            else
+            {
+                SysEnv.map_gen_jobs = atoi(next_arg);
+                if (SysEnv.map_gen_jobs < 1)
+                    SysEnv.map_gen_jobs = 1;
+                else if (SysEnv.map_gen_jobs > 256)
+                    SysEnv.map_gen_jobs = 256;
+                nextUsed = true;
+            }
+#else
+            fprintf(stderr, "mapstat and objstat are available only in "
+                    "DEBUG_STATISTICS builds.\n");
+            end(1);
+#endif
+            break;
+
         case CLO_ARENA:
             if (!rc_only)
             {
@@ -57,6 +57,7 @@ public:
     vector<string> cmd_args;
 
     int map_gen_iters;
+    int map_gen_jobs;
     unique_ptr<depth_ranges> map_gen_range;
 
     vector<string> extra_opts_first;
@@ -2251,6 +2251,7 @@ bool set_ident_type(object_class_type basetype, int subtype, bool identify)
 
     you.type_ids[basetype][subtype] = identify;
     request_autoinscribe();
+    invalidate_autopickup_cache();
 
     // Our item knowledge changed in a way that could possibly affect shop
     // prices.
@@ -3156,12 +3157,13 @@ bool is_interesting_item(const item_def& item)
     if (fully_identified(item) && is_artefact(item))
         return true;
 
-    const string iname = item_prefix(item, false) + " " + item.name(DESC_PLAIN);
-    for (const text_pattern &pat : Options.note_items)
-        if (pat.matches(iname))
-            return true;
+    static pattern_set note_items;
+    note_items.set_patterns(Options.note_items);
+    if (note_items.empty())
+        return false;
 
-    return false;
+    return note_items.matches(item_prefix(item, false) + " "
+                              + item.name(DESC_PLAIN));
 }
 
 /**
@@ -42,6 +42,7 @@
 #include "godpassive.h"
 #include "godprayer.h"
 #include "godwrath.h"
+#include "hash.h"
 #include "hints.h"
 #include "hints.h"
 #include "hiscores.h"
@@ -254,7 +255,7 @@ static int _cull_items()
     //  1. Don't cleanup anything nearby the player
     //  2. Don't cleanup shops
     //  3. Don't cleanup monster inventory
-    //  4. Clean 15% of items
+    //  4. Clean 15% of items, oldest first
     //  5. never remove food, orbs, runes
     //  7. uniques weapons are moved to the abyss
     //  8. randarts are simply lost
@@ -262,38 +263,42 @@ static int _cull_items()
     // 10. Remove +0 weapons and ammo first, only removing others if this fails.
 
     int first_cleaned = NON_ITEM;
-
-    // 2. Avoid shops by avoiding (0,5..9).
-    // 3. Avoid monster inventory by iterating over the dungeon grid.
+    const int cull_target = max(1, items_in_use() * 15 / 100);
+    int cull_count = 0;
 
     // 10. Remove +0 weapons and ammo first, only removing others if this fails.
     // Loop twice. First iteration, get rid of uninteresting stuff. Second
     // iteration, get rid of anything non-essential
     for (int remove_all=0; remove_all<2 && first_cleaned==NON_ITEM; remove_all++)
     {
-        for (rectangle_iterator ri(1); ri; ++ri)
+        for (int item = oldest_item(), next;
+             item != NON_ITEM && cull_count < cull_target; item = next)
         {
-            if (grid_distance(you.pos(), *ri) <= 8)
+            next = younger_item(item);
+            item_def &it = mitm[item];
+
+            // 2., 3. Only floor items have a position on the map.
+            if (!it.defined() || !in_bounds(it.pos)
+                || grid_distance(you.pos(), it.pos) <= 8)
+            {
                 continue;
+            }
 
-            for (stack_iterator si(*ri); si; ++si)
+            if (_item_ok_to_clean(item)
+                && (remove_all || _item_preferred_to_clean(item)))
             {
-                if (_item_ok_to_clean(si->index())
-                    && (remove_all || _item_preferred_to_clean(si->index()))
-                    && x_chance_in_y(15, 100))
+                if (is_unrandom_artefact(it))
                 {
-                    if (is_unrandom_artefact(*si))
-                    {
-                        // 7. Move uniques to abyss.
-                        set_unique_item_status(*si, UNIQ_LOST_IN_ABYSS);
-                    }
+                    // 7. Move uniques to abyss.
+                    set_unique_item_status(it, UNIQ_LOST_IN_ABYSS);
+                }
 
-                    if (first_cleaned == NON_ITEM)
-                        first_cleaned = si->index();
+                if (first_cleaned == NON_ITEM)
+                    first_cleaned = item;
 
-                    // POOF!
-                    destroy_item(si->index());
-                }
+                // POOF!
+                destroy_item(item);
+                cull_count++;
             }
         }
     }
@@ -436,6 +441,9 @@ bool dec_inv_item_quantity(int obj, int amount)
 
         ret = true;
 
+        // Autopickup hooks may look at what's in the pack.
+        invalidate_autopickup_cache();
+
         // If we're repeating a command, the repetitions used up the
         // item stack being repeated on, so stop rather than move onto
         // the next stack.
@@ -494,23 +502,157 @@ void init_item(int item)
     mitm[item].clear();
 }
 
+// Slots of mitm which are probably free, as a stack, so that handing out a
+// slot takes constant time rather than a search of the whole table.
+// destroy_item() pushes slots as it frees them, and the stack is refilled
+// whenever a level is cleared or loaded. Items are also cleared directly,
+// so a slot on the stack is only a hint, checked before use, and slots
+// freed behind its back are found again by refilling the stack when it
+// runs dry.
+//
+// The top ITEM_RESERVE_SLOTS slots are kept off the stack: callers may ask
+// for them to be left alone, and there are few enough of them to search.
+#define ITEM_RESERVE_SLOTS 50
+#define ITEM_STACK_SLOTS (MAX_ITEMS - ITEM_RESERVE_SLOTS)
+
+static int _free_stack[ITEM_STACK_SLOTS];
+static int _free_top = 0;
+static FixedBitVector<ITEM_STACK_SLOTS> _free_items;
+
+static void _push_free_item(int item)
+{
+    if (item < 0 || item >= ITEM_STACK_SLOTS || _free_items[item])
+        return;
+    _free_items.set(item);
+    _free_stack[_free_top++] = item;
+}
+
+static void _refill_free_items()
+{
+    _free_items.reset();
+    _free_top = 0;
+    // Lowest on top, so slots are handed out in the old order after a load.
+    for (int item = ITEM_STACK_SLOTS - 1; item >= 0; item--)
+        if (!mitm[item].defined())
+            _push_free_item(item);
+}
+
+// The slots in use, oldest first, as a list linked through _age_next and
+// _age_prev, so that culling can start with the items that have been
+// around longest without sorting the table. Handing out a slot appends
+// it, destroy_item() unlinks it, and slots cleared behind its back are
+// skipped by the walkers and unlinked when they're handed out again.
+static int _age_next[MAX_ITEMS];
+static int _age_prev[MAX_ITEMS];
+static int _age_oldest = NON_ITEM;
+static int _age_youngest = NON_ITEM;
+static int _aged_count = 0;
+static FixedBitVector<MAX_ITEMS> _aged;
+
+static void _age_unlink(int item)
+{
+    if (!_aged[item])
+        return;
+    _aged.set(item, false);
+    _aged_count--;
+
+    if (_age_prev[item] == NON_ITEM)
+        _age_oldest = _age_next[item];
+    else
+        _age_next[_age_prev[item]] = _age_next[item];
+    if (_age_next[item] == NON_ITEM)
+        _age_youngest = _age_prev[item];
+    else
+        _age_prev[_age_next[item]] = _age_prev[item];
+}
+
+static void _age_append(int item)
+{
+    _age_unlink(item);
+    _aged.set(item);
+    _aged_count++;
+
+    _age_prev[item] = _age_youngest;
+    _age_next[item] = NON_ITEM;
+    if (_age_youngest == NON_ITEM)
+        _age_oldest = item;
+    else
+        _age_next[_age_youngest] = item;
+    _age_youngest = item;
+}
+
+void rebuild_free_item_slots()
+{
+    _refill_free_items();
+
+    // The ages of loaded items aren't kept; go by slot order.
+    _aged.reset();
+    _aged_count = 0;
+    _age_oldest = _age_youngest = NON_ITEM;
+    for (int item = 0; item < MAX_ITEMS; item++)
+        if (mitm[item].defined())
+            _age_append(item);
+}
+
+int oldest_item()
+{
+    return _age_oldest;
+}
+
+int younger_item(int item)
+{
+    ASSERT_RANGE(item, 0, MAX_ITEMS);
+    return _aged[item] ? _age_next[item] : NON_ITEM;
+}
+
+int items_in_use()
+{
+    return _aged_count;
+}
+
+void refresh_item_age(int item)
+{
+    ASSERT_RANGE(item, 0, MAX_ITEMS);
+    if (mitm[item].defined())
+        _age_append(item);
+}
+
+// A free slot below limit, or NON_ITEM. Stale stack entries are dropped as
+// they are found.
+static int _find_free_item(int limit)
+{
+    while (_free_top > 0)
+    {
+        const int item = _free_stack[--_free_top];
+        _free_items.set(item, false);
+        if (!mitm[item].defined())
+            return item;
+    }
+
+    for (int item = ITEM_STACK_SLOTS; item < limit; item++)
+        if (!mitm[item].defined())
+            return item;
+    return NON_ITEM;
+}
+
 // Returns an unused mitm slot, or NON_ITEM if none available.
 // The reserve is the number of item slots to not check.
 // Items may be culled if a reserve <= 10 is specified.
 int get_mitm_slot(int reserve)
 {
-    ASSERT(reserve >= 0);
+    ASSERT_RANGE(reserve, 0, ITEM_RESERVE_SLOTS + 1);
 
     if (crawl_state.game_is_arena())
         reserve = 0;
 
-    int item = NON_ITEM;
-
-    for (item = 0; item < (MAX_ITEMS - reserve); item++)
-        if (!mitm[item].defined())
-            break;
+    int item = _find_free_item(MAX_ITEMS - reserve);
+    if (item == NON_ITEM)
+    {
+        _refill_free_items();
+        item = _find_free_item(MAX_ITEMS - reserve);
+    }
 
-    if (item >= MAX_ITEMS - reserve)
+    if (item == NON_ITEM)
     {
         if (crawl_state.game_is_arena())
         {
@@ -530,6 +672,7 @@ int get_mitm_slot(int reserve)
     ASSERT(item != NON_ITEM);
 
     init_item(item);
+    _age_append(item);
 
     return item;
 }
@@ -679,6 +822,17 @@ void destroy_item(item_def &item, bool never_created)
     }
 
     item.clear();
+
+    // Only items in mitm have a slot to free; index() means nothing for
+    // the player's inventory or temporary copies.
+    const item_def *first = mitm.buffer();
+    if (!less<const item_def *>()(&item, first)
+        && less<const item_def *>()(&item, first + MAX_ITEMS))
+    {
+        const int index = item.index();
+        _age_unlink(index);
+        _push_free_item(index);
+    }
 }
 
 void destroy_item(int dest, bool never_created)
@@ -1994,6 +2148,9 @@ static int _place_item_in_free_slot(item_def &it, int quant_got,
     // Remove "unobtainable" as it was just proven false.
     item.flags &= ~ISFLAG_UNOBTAINABLE;
 
+    // Autopickup hooks may look at what's in the pack.
+    invalidate_autopickup_cache();
+
     god_id_item(item);
     if (item.base_type == OBJ_WANDS)
         set_ident_type(item, true);
@@ -2819,18 +2976,40 @@ static int _autopickup_subtype(const item_def &item)
     }
 }
 
-static bool _is_option_autopickup(const item_def &item, bool ignore_force)
+// The autopickup options, and the Lua hooks and item names they look at,
+// are checked against a per-item cache. The fields that make up the item's
+// name go into the key. What the player knows about item types, their
+// inventory, mutations, form and god, and the options themselves, move the
+// epoch on instead, since ch_force_autopickup hooks look at those. Starts
+// at 1, since an item with an epoch of 0 has no cache.
+static unsigned int _autopickup_epoch = 1;
+
+void invalidate_autopickup_cache()
 {
-    string iname = _autopickup_item_name(item);
+    if (++_autopickup_epoch == 0)
+        ++_autopickup_epoch;
+}
 
-    if (item.base_type < NUM_OBJECT_CLASSES)
-    {
-        const int force = you.force_autopickup[item.base_type][_autopickup_subtype(item)];
-        if (!ignore_force && force != 0)
-            return force == 1;
-    }
-    else
-        return false;
+static uint32_t _autopickup_key(const item_def &item)
+{
+    fnv_hash32 hash;
+    hash.mix(item.base_type);
+    hash.mix(item.sub_type);
+    hash.mix((uint16_t) item.plus);
+    hash.mix((uint16_t) item.plus2);
+    hash.mix(item.special);
+    hash.mix(item.rnd);
+    hash.mix(item.quantity);
+    hash.mix(item.flags);
+    hash.mix(item.props.size());
+    for (char c : item.inscription)
+        hash.mix((uint8_t) c);
+    return hash.value();
+}
+
+static bool _check_option_autopickup(const item_def &item)
+{
+    string iname = _autopickup_item_name(item);
 
 #ifdef CLUA_BINDINGS
     maybe_bool res = clua.callmaybefn("ch_force_autopickup", "is",
@@ -2856,6 +3035,28 @@ static bool _is_option_autopickup(const item_def &item, bool ignore_force)
     return Options.autopickups[item.base_type];
 }
 
+static bool _is_option_autopickup(const item_def &item, bool ignore_force)
+{
+    if (item.base_type < NUM_OBJECT_CLASSES)
+    {
+        const int force = you.force_autopickup[item.base_type][_autopickup_subtype(item)];
+        if (!ignore_force && force != 0)
+            return force == 1;
+    }
+    else
+        return false;
+
+    const uint32_t key = _autopickup_key(item);
+    if (item.autopickup_epoch != _autopickup_epoch
+        || item.autopickup_key != key)
+    {
+        item.autopickup = _check_option_autopickup(item);
+        item.autopickup_epoch = _autopickup_epoch;
+        item.autopickup_key = key;
+    }
+    return item.autopickup;
+}
+
 /// Should the player automatically butcher the given item?
 static bool _should_autobutcher(const item_def &item)
 {
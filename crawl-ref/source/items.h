@@ -66,6 +66,13 @@ void link_items();
 void fix_item_coordinates();
 
 int get_mitm_slot(int reserve = 50);
+void rebuild_free_item_slots();
+// The mitm slots in use, from the one handed out longest ago. Fetch the
+// next slot before destroying the current one.
+int oldest_item();
+int younger_item(int item);
+int items_in_use();
+void refresh_item_age(int item);
 
 void unlink_item(int dest);
 void destroy_item(item_def &item, bool never_created = false);
@@ -125,6 +132,7 @@ bool origin_is_acquirement(const item_def& item,
                            item_source_type *type = nullptr);
 
 bool item_needs_autopickup(const item_def &, bool ignore_force = false);
+void invalidate_autopickup_cache();
 bool can_autopickup();
 
 bool need_to_autopickup();
@@ -12,14 +12,17 @@
 #include "chardump.h"
 #include "cluautil.h"
 #include "coordit.h"
+#include "database.h"
 #include "dungeon.h"
 #include "files.h"
 #include "godwrath.h"
 #include "los.h"
+#include "losglobal.h"
 #include "message.h"
 #include "mon-act.h"
 #include "mon-death.h"
 #include "mon-poly.h"
+#include "pattern.h"
 #include "religion.h"
 #include "stairs.h"
 #include "state.h"
@@ -117,6 +120,90 @@ LUAFN(debug_los_changed)
     return 0;
 }
 
+// Fill the LOS cache around every cell of a rectangle at once.
+LUAFN(debug_los_cache_region)
+{
+    const coord_def corner1(luaL_checkint(ls, 1), luaL_checkint(ls, 2));
+    const coord_def corner2(luaL_checkint(ls, 3), luaL_checkint(ls, 4));
+    cache_los_region(corner1, corner2, LOS_DEFAULT);
+    return 0;
+}
+
+// Returns hits, misses, evictions and resident tiles of the LOS cache.
+LUAFN(debug_los_cache_stats)
+{
+    const los_cache_stats stats = get_los_cache_stats();
+    lua_pushnumber(ls, stats.hits);
+    lua_pushnumber(ls, stats.misses);
+    lua_pushnumber(ls, stats.evictions);
+    lua_pushnumber(ls, stats.tiles);
+    return 4;
+}
+
+#ifdef DEBUG_TESTS
+// Time n LOS computations around the player with the old and the current
+// losight kernels; returns the milliseconds taken by each.
+LUAFN(debug_los_benchmark)
+{
+    const int n = lua_isnumber(ls, 1) ? luaL_checkint(ls, 1) : 1000;
+    double bitwise_ms, wordwise_ms;
+    los_kernel_benchmark(you.pos(), n, bitwise_ms, wordwise_ms);
+    lua_pushnumber(ls, bitwise_ms);
+    lua_pushnumber(ls, wordwise_ms);
+    return 2;
+}
+
+// Look a key up in the DB built from test/textdb.txt, rebuilding it first if
+// the file has changed; returns the body and the keys whose bodies contain
+// the given text.
+LUAFN(debug_textdb_lookup)
+{
+    vector<string> matches;
+    const string body = database_test_lookup(luaL_checkstring(ls, 1),
+                                             luaL_checkstring(ls, 2),
+                                             matches);
+    lua_pushstring(ls, body.c_str());
+    clua_stringtable(ls, matches);
+    return 2;
+}
+#endif
+
+// Put a table of patterns in a pattern_set, and return the (1-based) index
+// of the first to match the text, or nil, and whether any matched.
+LUAFN(debug_first_matching_pattern)
+{
+    if (!lua_istable(ls, 1))
+    {
+        luaL_argerror(ls, 1, "Unexpected argument type, wanted table");
+        return 0;
+    }
+    const string text = luaL_checkstring(ls, 2);
+    const bool icase = lua_toboolean(ls, 3);
+
+    vector<text_pattern> pats;
+    for (int i = 1; ; ++i)
+    {
+        lua_rawgeti(ls, 1, i);
+        if (lua_isnil(ls, -1))
+        {
+            lua_pop(ls, 1);
+            break;
+        }
+        pats.emplace_back(lua_tostring(ls, -1), icase);
+        lua_pop(ls, 1);
+    }
+
+    pattern_set set;
+    set.set_patterns(pats);
+    const int first = set.first_match(text);
+    if (first < 0)
+        lua_pushnil(ls);
+    else
+        lua_pushnumber(ls, first + 1);
+    lua_pushboolean(ls, set.matches(text));
+    return 2;
+}
+
 LUAFN(debug_dump_map)
 {
     const int pos = lua_isuserdata(ls, 1) ? 2 : 1;
@@ -375,7 +462,14 @@ const struct luaL_reg debug_dlib[] =
 { "generate_level", debug_generate_level },
 { "reveal_mimics", debug_reveal_mimics },
 { "los_changed", debug_los_changed },
+{ "los_cache_region", debug_los_cache_region },
+{ "los_cache_stats", debug_los_cache_stats },
+#ifdef DEBUG_TESTS
+{ "los_benchmark", debug_los_benchmark },
+{ "textdb_lookup", debug_textdb_lookup },
+#endif
 { "dump_map", debug_dump_map },
+{ "first_matching_pattern", debug_first_matching_pattern },
 { "test_explore", _debug_test_explore },
 { "bouncy_beam", debug_bouncy_beam },
 { "cull_monsters", debug_cull_monsters},
@@ -94,7 +94,9 @@ static int dgn_default_depth(lua_State *ls)
 static int dgn_depth(lua_State *ls)
 {
     MAP(ls, 1, map);
-    return dgn_depth_proc(ls, map->depths, 2);
+    const int ret = dgn_depth_proc(ls, map->depths, 2);
+    map_def_changed(map);
+    return ret;
 }
 
 static int dgn_place(lua_State *ls)
@@ -115,6 +117,7 @@ static int dgn_place(lua_State *ls)
                 luaL_error(ls, err.what());
             }
         }
+        map_def_changed(map);
     }
     PLUARET(string, map->place.describe().c_str());
 }
@@ -151,6 +154,7 @@ static int dgn_tags(lua_State *ls)
             const char *s = luaL_checkstring(ls, 2);
             map->tags += " " + trimmed_string(s) + " ";
         }
+        map_def_changed(map);
     }
     PLUARET(string, map->tags.c_str());
 }
@@ -171,6 +175,7 @@ static int dgn_tags_remove(lua_State *ls)
         const string axee = luaL_checkstring(ls, i);
         while (strip_tag(map->tags, axee));
     }
+    map_def_changed(map);
     PLUARET(string, map->tags.c_str());
 }
 
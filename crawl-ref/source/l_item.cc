@@ -1228,7 +1228,7 @@ static int l_item_get_items_at(lua_State *ls)
     if (!map_bounds(p))
         return 0;
 
-    item_def* top = env.map_knowledge(p).item();
+    const item_def* top = env.map_knowledge(p).item();
     if (!top || !top->defined())
         return 0;
 
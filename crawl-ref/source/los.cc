@@ -45,6 +45,7 @@
 #include "los.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 
 #include "areas.h"
@@ -52,6 +53,7 @@
 #include "coordit.h"
 #include "env.h"
 #include "losglobal.h"
+#include "mon-pathfind.h"
 
 // These determine what rays are cast in the precomputation,
 // and affect start-up time significantly.
@@ -83,6 +85,11 @@ static blockrays_t blockrays;
 struct cellray;
 static FixedArray<vector<cellray>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> min_cellrays;
 
+// For each cell p, the end cells of all minimal cellrays that p blocks;
+// that is, the cells whose visibility may depend on the opacity of p.
+// Used for incremental LOS updates (los_shadow).
+static FixedArray<vector<coord_def>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> shadows;
+
 // Temporary arrays used in losight() to track which rays
 // are blocked or have seen a smoke cloud.
 // Allocated when doing the precomputations.
@@ -213,7 +220,7 @@ struct cellray
     coord_def target() const { return ray_coords[index()]; }
 
     // XXX: Currently ray/cellray[0] is the first point outside the origin.
-    coord_def operator[](unsigned int i)
+    coord_def operator[](unsigned int i) const
     {
         ASSERT(i <= end);
         return ray_coords[ray.start+i];
@@ -422,6 +429,21 @@ static void _create_blockrays()
     for (quadrant_iterator qi; qi; ++qi)
         delete all_blockrays(*qi);
 
+    // Collect the shadow of each cell from the compressed blockrays.
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        FixedBitArray<LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> in_shadow;
+        for (int i = 0; i < n_min_rays; ++i)
+        {
+            const coord_def e = cellray_ends[i];
+            if (blockrays(*qi)->get(i) && !in_shadow(e))
+            {
+                in_shadow.set(e);
+                shadows(*qi).push_back(e);
+            }
+        }
+    }
+
     dead_rays  = new bit_vector(n_min_rays);
     smoke_rays = new bit_vector(n_min_rays);
 
@@ -785,7 +807,76 @@ bool cell_see_cell_nocache(const coord_def& p1, const coord_def& p2)
 // Smoke will now only block LOS after two cells of smoke. This is
 // done by updating with a second array.
 
+// Block the rays of a quadrant that pass through the cell q of that
+// quadrant, which has opacity opc.
+static void _block_rays(bit_vector &dead, bit_vector &smoke,
+                        const coord_def& q, opacity_type opc)
+{
+    switch (opc)
+    {
+    case OPC_OPAQUE:
+        // Block the appropriate rays.
+        dead |= *blockrays(q);
+        break;
+    case OPC_HALF:
+        // Block rays which have already seen a cloud.
+        dead.or_and(smoke, *blockrays(q));
+        smoke |= *blockrays(q);
+        break;
+    default:
+        break;
+    }
+}
+
+// Ray calculation done. Now work out which cells in this
+// quadrant are visible, skipping over dead rays a word at a time.
+static void _fill_quadrant(los_grid& sh, const bit_vector &dead,
+                           const los_param& dat, int sx, int sy)
+{
+    const unsigned int num_cellrays = cellray_ends.size();
+    const int nwords = dead.words();
+    for (int w = 0; w < nwords; ++w)
+    {
+        unsigned long alive = ~dead.word(w);
+        while (alive)
+        {
+            const unsigned int rayidx = w * LONGSIZE + lowest_set_bit(alive);
+            if (rayidx >= num_cellrays)
+                break;
+            alive &= alive - 1;
+
+            // This ray is alive, thus the end cell is visible.
+            // Many rays share an end cell; skip those already seen.
+            const coord_def p = coord_def(sx * cellray_ends[rayidx].x,
+                                          sy * cellray_ends[rayidx].y);
+            if (!sh(p) && dat.los_bounds(p))
+                sh(p) = true;
+        }
+    }
+}
+
 static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy)
+{
+    dead_rays->reset();
+    smoke_rays->reset();
+
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        coord_def p = coord_def(sx*(qi->x), sy*(qi->y));
+        if (!dat.los_bounds(p))
+            continue;
+
+        _block_rays(*dead_rays, *smoke_rays, *qi, dat.opacity(p));
+    }
+
+    _fill_quadrant(sh, *dead_rays, dat, sx, sy);
+}
+
+#ifdef DEBUG_TESTS
+// The original kernel, testing one ray at a time. Kept to check and
+// time _losight_quadrant against (see los_kernel_benchmark).
+static void _losight_quadrant_bitwise(los_grid& sh, const los_param& dat,
+                                      int sx, int sy)
 {
     const unsigned int num_cellrays = cellray_ends.size();
 
@@ -801,11 +892,9 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
         switch (dat.opacity(p))
         {
         case OPC_OPAQUE:
-            // Block the appropriate rays.
             *dead_rays |= *blockrays(*qi);
             break;
         case OPC_HALF:
-            // Block rays which have already seen a cloud.
             *dead_rays  |= (*smoke_rays & *blockrays(*qi));
             *smoke_rays |= *blockrays(*qi);
             break;
@@ -814,14 +903,10 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
         }
     }
 
-    // Ray calculation done. Now work out which cells in this
-    // quadrant are visible.
     for (unsigned int rayidx = 0; rayidx < num_cellrays; ++rayidx)
     {
-        // make the cells seen by this ray at this point visible
         if (!dead_rays->get(rayidx))
         {
-            // This ray is alive, thus the end cell is visible.
             const coord_def p = coord_def(sx * cellray_ends[rayidx].x,
                                           sy * cellray_ends[rayidx].y);
             if (dat.los_bounds(p))
@@ -829,6 +914,7 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
         }
     }
 }
+#endif
 
 struct los_param_funcs : public los_param
 {
@@ -873,6 +959,250 @@ void losight(los_grid& sh, const coord_def& center,
     sh(o) = true;
 }
 
+// Compute the fields around each of centers, as losight() would, into
+// the matching entries of fields.
+//
+// Rather than have every centre walk each cell in its range, one pass
+// over the cells around all of them looks up each opacity once and,
+// for a cell that blocks anything, blocks the rays through it for every
+// centre in range. Clear cells, the bulk of most maps, then cost one
+// lookup however many centres can see them. Only the remaining alive
+// rays are followed for each centre.
+void losight_batch(vector<los_grid>& fields, const vector<coord_def>& centers,
+                   const opacity_func& opc, const circle_def& bounds)
+{
+    const int n = centers.size();
+    fields.resize(n);
+    if (!n)
+        return;
+
+    // Do precomputations if necessary.
+    raycast();
+
+    const int span = 2 * LOS_MAX_RANGE + 1;
+    coord_def tl = centers[0];
+    coord_def br = centers[0];
+    for (const coord_def &c : centers)
+    {
+        tl.x = min(tl.x, c.x);
+        tl.y = min(tl.y, c.y);
+        br.x = max(br.x, c.x);
+        br.y = max(br.y, c.y);
+    }
+    tl -= coord_def(LOS_MAX_RANGE, LOS_MAX_RANGE);
+    br += coord_def(LOS_MAX_RANGE, LOS_MAX_RANGE);
+
+    // The shared pass visits every cell of the box around the centres;
+    // a few centres far apart are cheaper done one at a time.
+    if ((br.x - tl.x + 1) * (br.y - tl.y + 1) >= n * span * span)
+    {
+        for (int i = 0; i < n; ++i)
+            losight(fields[i], centers[i], opc, bounds);
+        return;
+    }
+
+    // Bucket the centres by blocks of span cells, so that those in range
+    // of a cell are found among at most two blocks in each direction.
+    const int bw = (br.x - tl.x) / span + 1;
+    const int bh = (br.y - tl.y) / span + 1;
+    vector<vector<int>> buckets(bw * bh);
+    for (int i = 0; i < n; ++i)
+    {
+        const coord_def b = (centers[i] - tl) / span;
+        buckets[b.x + b.y * bw].push_back(i);
+    }
+
+    const int quadrant_x[4] = {  1, -1, -1,  1 };
+    const int quadrant_y[4] = {  1,  1, -1, -1 };
+    const unsigned int num_cellrays = cellray_ends.size();
+    vector<bit_vector> dead(4 * n, bit_vector(num_cellrays));
+    vector<bit_vector> smoke(4 * n, bit_vector(num_cellrays));
+
+    const coord_def from(max(tl.x, 0), max(tl.y, 0));
+    const coord_def to(min(br.x, GXM - 1), min(br.y, GYM - 1));
+    for (rectangle_iterator ri(from, to); ri; ++ri)
+    {
+        const coord_def p = *ri;
+        if (!map_bounds(p))
+            continue;
+
+        const opacity_type o = opc(p);
+        if (o == OPC_CLEAR)
+            continue;
+
+        const int bx1 = max(0, p.x - LOS_MAX_RANGE - tl.x) / span;
+        const int by1 = max(0, p.y - LOS_MAX_RANGE - tl.y) / span;
+        const int bx2 = min(bw - 1, (p.x + LOS_MAX_RANGE - tl.x) / span);
+        const int by2 = min(bh - 1, (p.y + LOS_MAX_RANGE - tl.y) / span);
+        for (int by = by1; by <= by2; ++by)
+            for (int bx = bx1; bx <= bx2; ++bx)
+                for (int i : buckets[bx + by * bw])
+                {
+                    const coord_def rel = p - centers[i];
+                    if (rel.rdist() > LOS_MAX_RANGE || !bounds.contains(rel))
+                        continue;
+
+                    // Cells on an axis belong to both quadrants beside it.
+                    const coord_def q = coord_def(abs(rel.x), abs(rel.y));
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        if (quadrant_x[k] * rel.x >= 0
+                            && quadrant_y[k] * rel.y >= 0)
+                        {
+                            _block_rays(dead[4 * i + k], smoke[4 * i + k],
+                                        q, o);
+                        }
+                    }
+                }
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        const los_param& dat = los_param_funcs(centers[i], opc, bounds);
+        fields[i].init(false);
+        for (int k = 0; k < 4; ++k)
+        {
+            _fill_quadrant(fields[i], dead[4 * i + k], dat,
+                           quadrant_x[k], quadrant_y[k]);
+        }
+
+        // Center is always visible.
+        fields[i](coord_def(0, 0)) = true;
+    }
+}
+
+#ifdef DEBUG_TESTS
+// Run n full LOS computations around center with both the current and
+// the original quadrant kernel, and report the time each took in
+// milliseconds. Dies if the two kernels disagree.
+void los_kernel_benchmark(const coord_def& center, int n,
+                          double &bitwise_ms, double &wordwise_ms)
+{
+    const los_param& dat = los_param_funcs(center, opc_default, BDS_DEFAULT);
+    const int quadrant_x[4] = {  1, -1, -1,  1 };
+    const int quadrant_y[4] = {  1,  1, -1, -1 };
+    los_grid old_sh, new_sh;
+
+    raycast();
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i)
+    {
+        old_sh.init(false);
+        for (int q = 0; q < 4; ++q)
+            _losight_quadrant_bitwise(old_sh, dat, quadrant_x[q], quadrant_y[q]);
+    }
+    auto mid = chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i)
+    {
+        new_sh.init(false);
+        for (int q = 0; q < 4; ++q)
+            _losight_quadrant(new_sh, dat, quadrant_x[q], quadrant_y[q]);
+    }
+    auto end = chrono::steady_clock::now();
+
+    for (int x = -LOS_MAX_RANGE; x <= LOS_MAX_RANGE; ++x)
+        for (int y = -LOS_MAX_RANGE; y <= LOS_MAX_RANGE; ++y)
+        {
+            if (old_sh(coord_def(x, y)) != new_sh(coord_def(x, y)))
+            {
+                die("LOS kernels disagree at %d,%d from %d,%d",
+                    x, y, center.x, center.y);
+            }
+        }
+
+    bitwise_ms = chrono::duration<double, milli>(mid - start).count();
+    wordwise_ms = chrono::duration<double, milli>(end - mid).count();
+}
+#endif
+
+// Is the end cell of any of the given minimal cellrays visible?
+// This is _losight_quadrant restricted to the rays in question.
+static bool _cellrays_alive(const vector<cellray>& rays,
+                            const los_param& dat, int sx, int sy)
+{
+    for (const cellray &c : rays)
+    {
+        bool smoke = false;
+        bool dead = false;
+        for (unsigned int j = 0; j < c.end && !dead; ++j)
+        {
+            const coord_def p = coord_def(sx * c[j].x, sy * c[j].y);
+            if (!dat.los_bounds(p))
+                continue;
+
+            switch (dat.opacity(p))
+            {
+            case OPC_OPAQUE:
+                dead = true;
+                break;
+            case OPC_HALF:
+                dead = smoke;
+                smoke = true;
+                break;
+            default:
+                break;
+            }
+        }
+        if (!dead)
+            return true;
+    }
+    return false;
+}
+
+// Compute the visibility of a single cell, giving the same result as
+// losight(sh, center, opc, bounds) would for sh(target - center).
+// Only the minimal cellrays ending at the target are traced, which
+// is much cheaper than a full losight() if few cells need updating.
+bool losight_cell(const coord_def& center, const coord_def& target,
+                  const opacity_func& opc, const circle_def& bounds)
+{
+    const los_param& dat = los_param_funcs(center, opc, bounds);
+    const coord_def d = target - center;
+
+    if (d.origin())
+        return true;
+    if (d.rdist() > LOS_MAX_RANGE || !dat.los_bounds(d))
+        return false;
+
+    raycast();
+
+    const vector<cellray> &rays = min_cellrays(coord_def(abs(d.x), abs(d.y)));
+    // Cells on an axis belong to two quadrants, and are visible if
+    // they are visible in either of them.
+    for (int sx = -1; sx <= 1; sx += 2)
+        for (int sy = -1; sy <= 1; sy += 2)
+        {
+            if (d.x * sx < 0 || d.y * sy < 0)
+                continue;
+            if (_cellrays_alive(rays, dat, sx, sy))
+                return true;
+        }
+    return false;
+}
+
+// Append to shadow the cells (relative to a viewer at the origin) whose
+// visibility may change when the opacity of the cell at blocker changes.
+// Cells on the axes may be listed more than once.
+void los_shadow(const coord_def& blocker, vector<coord_def>& shadow)
+{
+    if (blocker.origin() || blocker.rdist() > LOS_MAX_RANGE)
+        return;
+
+    raycast();
+
+    const vector<coord_def> &quad = shadows(coord_def(abs(blocker.x),
+                                                      abs(blocker.y)));
+    for (int sx = -1; sx <= 1; sx += 2)
+        for (int sy = -1; sy <= 1; sy += 2)
+        {
+            if (blocker.x * sx < 0 || blocker.y * sy < 0)
+                continue;
+            for (const coord_def &c : quad)
+                shadow.emplace_back(sx * c.x, sy * c.y);
+        }
+}
+
 opacity_type mons_opacity(const monster* mon, los_type how)
 {
     // no regard for LOS_ARENA
@@ -924,11 +1254,13 @@ void los_monster_died(const monster* mon)
 void los_terrain_changed(const coord_def& p)
 {
     invalidate_los_around(p);
+    invalidate_flow_fields_at(p);
     _handle_los_change();
 }
 
 void los_changed()
 {
     invalidate_los();
+    invalidate_flow_fields();
     _handle_los_change();
 }
@@ -45,6 +45,17 @@ void clear_rays_on_exit();
 void losight(los_grid& sh, const coord_def& center,
              const opacity_func &opc = opc_default,
              const circle_def &bds = BDS_DEFAULT);
+void losight_batch(vector<los_grid>& fields, const vector<coord_def>& centers,
+                   const opacity_func &opc = opc_default,
+                   const circle_def &bds = BDS_DEFAULT);
+bool losight_cell(const coord_def& center, const coord_def& target,
+                  const opacity_func &opc = opc_default,
+                  const circle_def &bds = BDS_DEFAULT);
+void los_shadow(const coord_def& blocker, vector<coord_def>& shadow);
+#ifdef DEBUG_TESTS
+void los_kernel_benchmark(const coord_def& center, int n,
+                          double &bitwise_ms, double &wordwise_ms);
+#endif
 
 void los_actor_moved(const actor* act, const coord_def& oldpos);
 void los_monster_died(const monster* mon);
@@ -5,19 +5,105 @@
 #include "coord.h"
 #include "coordit.h"
 #include "libutil.h"
-#include "los_def.h"
+#include "los.h"
 
 #define LOS_KNOWN 4
 
+// Each entry packs two bits per los_type: whether it is known, and if
+// so whether the cells see each other.
 typedef uint8_t losfield_t;
 typedef losfield_t halflos_t[LOS_MAX_RANGE+1][2*LOS_MAX_RANGE+1];
 static const int o_half_x = 0;
 static const int o_half_y = LOS_MAX_RANGE;
-typedef halflos_t globallos_t[GXM][GYM];
 
-static globallos_t globallos;
+// The cache is split into square tiles of centres, allocated when a
+// field in that part of the level is first needed. Once there are
+// LOS_CACHE_MAX_TILES of them, the least recently used one is dropped.
+#define LOS_TILE 8
+#define LOS_TILES_X ((GXM + LOS_TILE - 1) / LOS_TILE)
+#define LOS_TILES_Y ((GYM + LOS_TILE - 1) / LOS_TILE)
+#define LOS_CACHE_MAX_TILES 40
 
-static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
+struct globallos_tile
+{
+    halflos_t fields[LOS_TILE][LOS_TILE];
+    // The los_types for which a full field has been computed around
+    // each centre. Unknown entries for such centres have been
+    // invalidated by a local opacity change, and are recomputed one
+    // cell at a time rather than with a full losight().
+    uint8_t centres[LOS_TILE][LOS_TILE];
+    unsigned int last_used;
+
+    globallos_tile() : last_used(0)
+    {
+        memset(fields, 0, sizeof(fields));
+        memset(centres, 0, sizeof(centres));
+    }
+};
+
+static FixedArray<globallos_tile*, LOS_TILES_X, LOS_TILES_Y> globallos(nullptr);
+static int globallos_ntiles = 0;
+static unsigned int globallos_clock = 0;
+static los_cache_stats globallos_stats;
+
+// Detach the least recently used tile, and return it for reuse.
+static globallos_tile* _evict_globallos_tile()
+{
+    globallos_tile** oldest = nullptr;
+    for (int x = 0; x < LOS_TILES_X; ++x)
+        for (int y = 0; y < LOS_TILES_Y; ++y)
+        {
+            globallos_tile* &tile = globallos[x][y];
+            if (tile && (!oldest || tile->last_used < (*oldest)->last_used))
+                oldest = &tile;
+        }
+
+    ASSERT(oldest);
+    globallos_tile* tile = *oldest;
+    *oldest = nullptr;
+    ++globallos_stats.evictions;
+    return tile;
+}
+
+// The tile holding the fields around centre p. If alloc is false and
+// the tile isn't resident, returns nullptr.
+static globallos_tile* _globallos_tile(const coord_def& p, bool alloc = true)
+{
+    globallos_tile* &tile = globallos[p.x / LOS_TILE][p.y / LOS_TILE];
+    if (!tile)
+    {
+        if (!alloc)
+            return nullptr;
+        if (globallos_ntiles >= LOS_CACHE_MAX_TILES)
+        {
+            tile = _evict_globallos_tile();
+            *tile = globallos_tile();
+        }
+        else
+        {
+            tile = new globallos_tile;
+            ++globallos_ntiles;
+            globallos_stats.peak_tiles = max(globallos_stats.peak_tiles,
+                                             globallos_ntiles);
+        }
+    }
+    tile->last_used = ++globallos_clock;
+    return tile;
+}
+
+static uint8_t& _globallos_centre(globallos_tile* tile, const coord_def& p)
+{
+    return tile->centres[p.x % LOS_TILE][p.y % LOS_TILE];
+}
+
+static uint8_t _globallos_centre_known(const coord_def& p)
+{
+    globallos_tile* tile = _globallos_tile(p, false);
+    return tile ? _globallos_centre(tile, p) : 0;
+}
+
+static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q,
+                                     bool alloc = true)
 {
     COMPILE_CHECK(LOS_KNOWN * 2 <= sizeof(losfield_t) * 8);
 
@@ -27,15 +113,18 @@ static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
     if (diff.rdist() > LOS_RADIUS)
         return nullptr;
     // p < q iff p.x < q.x || p.x == q.x && p.y < q.y
+    const coord_def o = diff < coord_def(0, 0) ? q : p;
     if (diff < coord_def(0, 0))
-        return &globallos[q.x][q.y][-diff.x + o_half_x][-diff.y + o_half_y];
-    else
-        return &globallos[p.x][p.y][ diff.x + o_half_x][ diff.y + o_half_y];
+        diff = -diff;
+    globallos_tile* tile = _globallos_tile(o, alloc);
+    if (!tile)
+        return nullptr;
+    return &tile->fields[o.x % LOS_TILE][o.y % LOS_TILE]
+                        [diff.x + o_half_x][diff.y + o_half_y];
 }
 
-static void _save_los(los_def* los, los_type l)
+static void _save_los(const coord_def& o, const los_grid& sh, los_type l)
 {
-    const coord_def o = los->get_center();
     int y1 = o.y - LOS_MAX_RANGE;
     int y2 = o.y + LOS_MAX_RANGE;
     int x1 = o.x - LOS_MAX_RANGE;
@@ -51,68 +140,121 @@ static void _save_los(los_def* los, los_type l)
             if (!flags)
                 continue;
             *flags |= l << LOS_KNOWN;
-            if (los->see_cell(ri))
+            if (sh(ri - o))
                 *flags |= l;
             else
                 *flags &= ~l;
         }
+    _globallos_centre(_globallos_tile(o), o) |= l;
 }
 
 // Opacity at p has changed.
+// Only pairs of cells connected by a cellray through p can be affected,
+// so forget just those, leaving the rest of each field cached.
 void invalidate_los_around(const coord_def& p)
 {
-    int x1 = max(p.x - LOS_MAX_RANGE, 0);
-    int y1 = max(p.y - LOS_MAX_RANGE, 0);
-    int x2 = min(p.x, GXM - 1);
-    int y2 = min(p.y + LOS_MAX_RANGE, GYM - 1);
-    for (int y = y1; y <= y2; y++)
-        for (int x = x1; x <= x2; x++)
-            memset(globallos[x][y], 0, sizeof(halflos_t));
+    vector<coord_def> shadow;
+    for (rectangle_iterator ri(p, LOS_MAX_RANGE); ri; ++ri)
+    {
+        if (!map_bounds(*ri))
+            continue;
+
+        shadow.clear();
+        los_shadow(p - *ri, shadow);
+        for (const coord_def &s : shadow)
+            if (losfield_t* flags = _lookup_globallos(*ri, *ri + s, false))
+                *flags = 0;
+    }
 }
 
 void invalidate_los()
 {
-    for (rectangle_iterator ri(0); ri; ++ri)
-        memset(globallos[ri->x][ri->y], 0, sizeof(halflos_t));
+    for (int x = 0; x < LOS_TILES_X; ++x)
+        for (int y = 0; y < LOS_TILES_Y; ++y)
+        {
+            delete globallos[x][y];
+            globallos[x][y] = nullptr;
+        }
+    globallos_ntiles = 0;
+}
+
+los_cache_stats get_los_cache_stats()
+{
+    los_cache_stats stats = globallos_stats;
+    stats.tiles = globallos_ntiles;
+    stats.tile_bytes = sizeof(globallos_tile);
+    return stats;
 }
 
-static void _update_globallos_at(const coord_def& p, los_type l)
+static const opacity_func& _globallos_opacity(los_type l)
 {
     switch (l)
     {
     case LOS_DEFAULT:
-        {
-            los_def los(p, opc_default);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
+        return opc_default;
     case LOS_NO_TRANS:
-        {
-            los_def los(p, opc_no_trans);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
+        return opc_no_trans;
     case LOS_SOLID:
-        {
-            los_def los(p, opc_solid);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
+        return opc_solid;
     case LOS_SOLID_SEE:
-        {
-            los_def los(p, opc_solid_see);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
+        return opc_solid_see;
     default:
         die("invalid opacity");
     }
 }
 
+static void _update_globallos_at(const coord_def& p, los_type l)
+{
+    los_grid sh;
+    losight(sh, p, _globallos_opacity(l));
+    _save_los(p, sh, l);
+}
+
+// Fill the cache with the fields of type l around all the given
+// sources at once (see losight_batch). Sources whose field is already
+// known are skipped.
+void cache_los_fields(const vector<coord_def>& sources, los_type l)
+{
+    if (l == LOS_NONE)
+        return;
+
+    vector<coord_def> centres;
+    for (const coord_def &p : sources)
+        if (map_bounds(p) && !(_globallos_centre_known(p) & l))
+            centres.push_back(p);
+
+    // Several monsters may share a position (e.g. submerged ones).
+    sort(centres.begin(), centres.end());
+    centres.erase(unique(centres.begin(), centres.end()), centres.end());
+
+    vector<los_grid> fields;
+    losight_batch(fields, centres, _globallos_opacity(l));
+    for (unsigned int i = 0; i < centres.size(); ++i)
+        _save_los(centres[i], fields[i], l);
+}
+
+// Fill the cache with the fields of type l around every cell of the
+// rectangle between the given corners.
+void cache_los_region(const coord_def& corner1, const coord_def& corner2,
+                      los_type l)
+{
+    vector<coord_def> sources;
+    for (rectangle_iterator ri(corner1, corner2); ri; ++ri)
+        sources.push_back(*ri);
+    cache_los_fields(sources, l);
+}
+
+static void _update_globallos_pair(const coord_def& p, const coord_def& q,
+                                   los_type l)
+{
+    losfield_t* flags = _lookup_globallos(p, q);
+    *flags |= l << LOS_KNOWN;
+    if (losight_cell(p, q, _globallos_opacity(l)))
+        *flags |= l;
+    else
+        *flags &= ~l;
+}
+
 bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l)
 {
     if (l == LOS_NONE)
@@ -123,8 +265,18 @@ bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l)
     if (!flags)
         return false; // outside range
 
-    if (!(*flags & (l << LOS_KNOWN)))
-        _update_globallos_at(p, l);
+    if (*flags & (l << LOS_KNOWN))
+        ++globallos_stats.hits;
+    else
+    {
+        ++globallos_stats.misses;
+        if ((_globallos_centre_known(p) | _globallos_centre_known(q)) & l)
+            _update_globallos_pair(p, q, l);
+        else
+            _update_globallos_at(p, l);
+        // Filling in the field may have evicted older tiles.
+        flags = _lookup_globallos(p, q);
+    }
 
     //if (!(*flags & (l << LOS_KNOWN)))
     //    die("cell_see_cell %d,%d %d,%d", p.x,p.y,q.x,q.y);
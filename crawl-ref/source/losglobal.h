@@ -4,6 +4,21 @@
 void invalidate_los_around(const coord_def& p);
 void invalidate_los();
 
+struct los_cache_stats
+{
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+    unsigned long evictions = 0;
+    int tiles = 0;          // currently resident
+    int peak_tiles = 0;
+    size_t tile_bytes = 0;
+};
+los_cache_stats get_los_cache_stats();
+
 bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l);
 
+void cache_los_fields(const vector<coord_def>& sources, los_type l);
+void cache_los_region(const coord_def& corner1, const coord_def& corner2,
+                      los_type l);
+
 #endif
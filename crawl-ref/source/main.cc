@@ -554,6 +554,11 @@ static void _show_commandline_options_help()
     puts("      Defaults to entire dungeon; same level syntax as -mapstat.");
     puts("  -iters <num>        For -mapstat and -objstat, set the number of "
          "iterations");
+#ifndef TARGET_OS_WINDOWS
+    puts("  -jobs <num>         For -mapstat and -objstat, split the iterations "
+         "over <num>");
+    puts("      processes.");
+#endif
 #endif
     puts("");
     puts("Miscellaneous options:");
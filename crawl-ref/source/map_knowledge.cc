@@ -10,6 +10,7 @@
 #include "notes.h"
 #include "religion.h"
 #include "terrain.h"
+#include "travel.h"
 #ifdef USE_TILE
  #include "tilepick.h"
  #include "tileview.h"
@@ -21,6 +22,7 @@ void set_terrain_mapped(const coord_def gc)
     map_cell* cell = &env.map_knowledge(gc);
     cell->flags &= (~MAP_CHANGED_FLAG);
     cell->flags |= MAP_MAGIC_MAPPED_FLAG;
+    update_travel_region_cell(gc);
 #ifdef USE_TILE
     tiles.update_minimap(gc);
 #endif
@@ -119,6 +121,7 @@ void set_terrain_seen(const coord_def pos)
 
     cell->flags &= (~MAP_CHANGED_FLAG);
     cell->flags |= MAP_SEEN_FLAG;
+    update_travel_region_cell(pos);
 
 #ifdef USE_TILE
     tiles.update_minimap(pos);
@@ -148,9 +151,10 @@ void map_cell::set_detected_item()
 {
     clear_item();
     flags |= MAP_DETECTED_ITEM;
-    _item = new item_info();
-    _item->base_type = OBJ_DETECTED;
-    _item->rnd       = 1;
+    item_info ii;
+    ii.base_type = OBJ_DETECTED;
+    ii.rnd       = 1;
+    _item = new map_payload<item_info>(ii);
 }
 
 static bool _floor_mf(map_feature mf)
@@ -250,8 +254,8 @@ bool map_cell::update_cloud_state()
         return false; // we're already up-to-date
 
     // player non-opaque clouds vanish instantly out of los
-    if (_cloud && _cloud->killer == KILL_YOU_MISSILE
-        && !is_opaque_cloud(_cloud->type))
+    if (_cloud && _cloud->value.killer == KILL_YOU_MISSILE
+        && !is_opaque_cloud(_cloud->value.type))
     {
         clear_cloud();
         return true;
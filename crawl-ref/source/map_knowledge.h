@@ -24,6 +24,20 @@ struct cloud_info
     killer_type killer;
 };
 
+/*
+ * A monster, item or cloud as the player last saw it. These never change
+ * once made, so copies of a map_cell share them; copying a map_cell (or a
+ * whole MapKnowledge) only bumps the reference counts.
+ */
+template <typename T>
+struct map_payload
+{
+    explicit map_payload(const T &v) : value(v), refs(1) { }
+
+    const T value;
+    unsigned int refs;
+};
+
 #define MAP_MAGIC_MAPPED_FLAG   0x01
 #define MAP_SEEN_FLAG           0x02
 #define MAP_CHANGED_FLAG        0x04 // FIXME: this doesn't belong here
@@ -71,41 +85,29 @@ struct map_cell
     map_cell(const map_cell& c)
     {
         memcpy(this, &c, sizeof(map_cell));
-        if (_cloud)
-            _cloud = new cloud_info(*_cloud);
-        if (_mons)
-            _mons = new monster_info(*_mons);
-        if (_item)
-            _item = new item_info(*_item);
+        _share(_cloud);
+        _share(_item);
+        _share(_mons);
     }
 
     ~map_cell()
     {
-        if (_cloud)
-            delete _cloud;
-        if (!(flags & MAP_DETECTED_MONSTER) && _mons)
-            delete _mons;
-        if (_item)
-            delete _item;
+        _release(_cloud);
+        _release(_item);
+        _release(_mons);
     }
 
     map_cell& operator=(const map_cell& c)
     {
         if (&c == this)
             return *this;
-        if (_cloud)
-            delete _cloud;
-        if (_mons)
-            delete _mons;
-        if (_item)
-            delete _item;
+        _share(c._cloud);
+        _share(c._item);
+        _share(c._mons);
+        _release(_cloud);
+        _release(_item);
+        _release(_mons);
         memcpy(this, &c, sizeof(map_cell));
-        if (_cloud)
-            _cloud = new cloud_info(*_cloud);
-        if (_mons)
-            _mons = new monster_info(*_mons);
-        if (_item)
-            _item = new item_info(*_item);
         return *this;
     }
 
@@ -144,9 +146,9 @@ struct map_cell
         _trap = tr;
     }
 
-    item_info* item() const
+    const item_info* item() const
     {
-        return _item;
+        return _item ? &_item->value : nullptr;
     }
 
     bool detected_item() const
@@ -164,40 +166,43 @@ struct map_cell
     void set_item(const item_info& ii, bool more_items)
     {
         clear_item();
-        _item = new item_info(ii);
+        _item = new map_payload<item_info>(ii);
         if (more_items)
             flags |= MAP_MORE_ITEMS;
     }
 
     void set_detected_item();
 
+    // Change the remembered item, keeping the item flags of the cell.
+    void replace_item(const item_info& ii)
+    {
+        _release(_item);
+        _item = new map_payload<item_info>(ii);
+    }
+
     void clear_item()
     {
-        if (_item)
-        {
-            delete _item;
-            _item = 0;
-        }
+        _release(_item);
         flags &= ~(MAP_DETECTED_ITEM | MAP_MORE_ITEMS);
     }
 
     monster_type monster() const
     {
         if (_mons)
-            return _mons->type;
+            return _mons->value.type;
         else
             return MONS_NO_MONSTER;
     }
 
-    monster_info* monsterinfo() const
+    const monster_info* monsterinfo() const
     {
-        return _mons;
+        return _mons ? &_mons->value : nullptr;
     }
 
     void set_monster(const monster_info& mi)
     {
         clear_monster();
-        _mons = new monster_info(mi);
+        _mons = new map_payload<monster_info>(mi);
     }
 
     bool detected_monster() const
@@ -213,8 +218,9 @@ struct map_cell
     void set_detected_monster(monster_type mons)
     {
         clear_monster();
-        _mons = new monster_info(MONS_SENSED);
-        _mons->base_type = mons;
+        monster_info mi(MONS_SENSED);
+        mi.base_type = mons;
+        _mons = new map_payload<monster_info>(mi);
         flags |= MAP_DETECTED_MONSTER;
     }
 
@@ -226,16 +232,14 @@ struct map_cell
 
     void clear_monster()
     {
-        if (_mons)
-            delete _mons;
+        _release(_mons);
         flags &= ~(MAP_DETECTED_MONSTER | MAP_INVISIBLE_MONSTER);
-        _mons = 0;
     }
 
     cloud_type cloud() const
     {
         if (_cloud)
-            return _cloud->type;
+            return _cloud->value.type;
         else
             return CLOUD_NONE;
     }
@@ -243,30 +247,25 @@ struct map_cell
     unsigned cloud_colour() const
     {
         if (_cloud)
-            return _cloud->colour;
+            return _cloud->value.colour;
         else
             return 0;
     }
 
-    cloud_info* cloudinfo() const
+    const cloud_info* cloudinfo() const
     {
-        return _cloud;
+        return _cloud ? &_cloud->value : nullptr;
     }
 
     void set_cloud(const cloud_info& ci)
     {
-        if (_cloud)
-            delete _cloud;
-        _cloud = new cloud_info(ci);
+        _release(_cloud);
+        _cloud = new map_payload<cloud_info>(ci);
     }
 
     void clear_cloud()
     {
-        if (_cloud)
-        {
-            delete _cloud;
-            _cloud = 0;
-        }
+        _release(_cloud);
     }
 
     bool update_cloud_state();
@@ -304,12 +303,27 @@ struct map_cell
 public:
     uint32_t flags;   // Flags describing the mappedness of this square.
 private:
+    template <typename T>
+    static void _share(map_payload<T> *payload)
+    {
+        if (payload)
+            ++payload->refs;
+    }
+
+    template <typename T>
+    static void _release(map_payload<T> *&payload)
+    {
+        if (payload && !--payload->refs)
+            delete payload;
+        payload = nullptr;
+    }
+
     dungeon_feature_type _feat:8;
     colour_t _feat_colour;
     trap_type _trap:8;
-    cloud_info* _cloud;
-    item_info* _item;
-    monster_info* _mons;
+    map_payload<cloud_info>* _cloud;
+    map_payload<item_info>* _item;
+    map_payload<monster_info>* _mons;
 };
 
 void set_terrain_mapped(const coord_def c);
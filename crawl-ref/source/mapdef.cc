@@ -13,6 +13,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <list>
+#include <unordered_map>
 
 #include "abyss.h"
 #include "artefact.h"
@@ -2398,11 +2400,111 @@ void map_def::strip()
     feat_renames.clear();
 }
 
+// The Lua code of recently loaded maps, most recently used first, so that
+// reusing a stripped map doesn't mean reading it back from its .dsc.
+struct map_body
+{
+    string name;
+    string cache_name;
+    long cache_offset;
+    dlua_chunk prelude, mapchunk, main, validate, veto, epilogue;
+    size_t size;
+};
+typedef list<map_body> map_body_list;
+static map_body_list map_bodies;
+static unordered_map<string, map_body_list::iterator> map_body_index;
+static size_t map_bodies_size = 0;
+
+static size_t _chunk_size(const dlua_chunk &chunk)
+{
+    return chunk.lua_string().size() + chunk.compiled_chunk().size();
+}
+
+static void _trim_map_bodies(size_t budget)
+{
+    while (map_bodies_size > budget && !map_bodies.empty())
+    {
+        map_bodies_size -= map_bodies.back().size;
+        map_body_index.erase(map_bodies.back().name);
+        map_bodies.pop_back();
+    }
+}
+
+void clear_map_body_cache()
+{
+    map_bodies.clear();
+    map_body_index.clear();
+    map_bodies_size = 0;
+}
+
+bool map_def::load_cached_body()
+{
+    auto it = map_body_index.find(name);
+    if (it == map_body_index.end())
+        return false;
+
+    const map_body &body = *it->second;
+    if (body.cache_name != cache_name || body.cache_offset != cache_offset)
+        return false;
+
+    prelude = body.prelude;
+    mapchunk = body.mapchunk;
+    main = body.main;
+    validate = body.validate;
+    veto = body.veto;
+    epilogue = body.epilogue;
+
+    map_bodies.splice(map_bodies.begin(), map_bodies, it->second);
+    return true;
+}
+
+void map_def::cache_body() const
+{
+    const size_t budget = Options.map_cache_size * 1024 * 1024;
+
+    map_body body;
+    body.size = sizeof(map_body) + name.size()
+                + _chunk_size(prelude) + _chunk_size(mapchunk)
+                + _chunk_size(main) + _chunk_size(validate)
+                + _chunk_size(veto) + _chunk_size(epilogue);
+    if (body.size > budget)
+        return;
+
+    auto old = map_body_index.find(name);
+    if (old != map_body_index.end())
+    {
+        map_bodies_size -= old->second->size;
+        map_bodies.erase(old->second);
+        map_body_index.erase(old);
+    }
+    _trim_map_bodies(budget - body.size);
+
+    body.name = name;
+    body.cache_name = cache_name;
+    body.cache_offset = cache_offset;
+    body.prelude = prelude;
+    body.mapchunk = mapchunk;
+    body.main = main;
+    body.validate = validate;
+    body.veto = veto;
+    body.epilogue = epilogue;
+
+    map_bodies.push_front(move(body));
+    map_body_index[name] = map_bodies.begin();
+    map_bodies_size += map_bodies.front().size;
+}
+
 void map_def::load()
 {
     if (!index_only)
         return;
 
+    if (load_cached_body())
+    {
+        index_only = false;
+        return;
+    }
+
     const string descache_base = get_descache_path(cache_name, "");
     file_lock deslock(descache_base + ".lk", "rb", false);
     const string loadfile = descache_base + ".dsc";
@@ -2417,6 +2519,7 @@ void map_def::load()
     read_full(inf, true);
 
     index_only = false;
+    cache_body();
 }
 
 vector<coord_def> map_def::find_glyph(int glyph) const
@@ -3244,16 +3347,38 @@ void map_def::fixup()
     }
 }
 
+// Is tag (of length len) one of the space-separated words in tags?
+static bool _has_word(const string &tags, const char *tag, size_t len)
+{
+    for (size_t pos = tags.find(tag, 0, len); pos != string::npos;
+         pos = tags.find(tag, pos + 1, len))
+    {
+        if (pos > 0 && tags[pos - 1] == ' '
+            && pos + len < tags.size() && tags[pos + len] == ' ')
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool map_def::has_tag(const string &tagwanted) const
 {
     if (tags.empty() || tagwanted.empty())
         return false;
 
-    vector<string> wanted_tags = split_string(" ", tagwanted);
-
-    for (const string &tag : wanted_tags)
-        if (tags.find(" " + tag + " ") == string::npos)
+    // Checked for every map in most vault selections, so avoid splitting
+    // tagwanted into temporary strings.
+    for (size_t start = 0, end; start < tagwanted.size(); start = end + 1)
+    {
+        end = tagwanted.find(' ', start);
+        if (end == string::npos)
+            end = tagwanted.size();
+        if (end == start)
+            continue;
+        if (!_has_word(tags, tagwanted.data() + start, end - start))
             return false;
+    }
 
     return true;
 }
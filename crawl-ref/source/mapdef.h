@@ -985,6 +985,7 @@ public:
     bool is_usable_in(const level_id &lid) const;
     void add_depth(const level_range &range) { depths.push_back(range); }
     void add_depths(const depth_ranges &other_ranges);
+    const depth_ranges_v &get_ranges() const { return depths; }
     string describe() const;
 };
 
@@ -1320,11 +1321,14 @@ private:
     string apply_subvault(string_spec &);
     string validate_map_placeable();
     bool has_exit() const;
+    bool load_cached_body();
+    void cache_body() const;
 };
 
 const int CHANCE_ROLL = 10000;
 
 void clear_subvault_stack();
+void clear_map_body_cache();
 
 void map_register_flag(const string &flag);
 
@@ -12,6 +12,7 @@
 #include <cstring>
 #include <sys/param.h>
 #include <sys/types.h>
+#include <unordered_map>
 #ifndef TARGET_COMPILER_VC
 #include <unistd.h>
 #endif
@@ -714,6 +715,170 @@ vector<string> find_map_matches(const string &name)
     return matches;
 }
 
+typedef vector<unsigned> vault_indices;
+
+// Indices into vdefs of the maps that might be usable in a given place,
+// going by one of their depth_ranges. Ranges that can't be tied to
+// particular depths ahead of time (any branch, or a branch's last level)
+// are kept to one side and always checked.
+struct map_depth_index
+{
+    FixedVector<FixedVector<vault_indices, MAX_BRANCH_DEPTH + 1>,
+                NUM_BRANCHES> by_depth;
+    FixedVector<vault_indices, NUM_BRANCHES> branch_end;
+    vault_indices any_branch;
+
+    void clear()
+    {
+        for (auto &depths : by_depth)
+            for (vault_indices &maps : depths)
+                maps.clear();
+        for (vault_indices &maps : branch_end)
+            maps.clear();
+        any_branch.clear();
+    }
+
+    void add(unsigned map, const depth_ranges &ranges)
+    {
+        for (const level_range &lr : ranges.get_ranges())
+        {
+            // Deny ranges only ever remove places.
+            if (lr.deny)
+                continue;
+
+            if (lr.branch < 0 || lr.branch >= NUM_BRANCHES)
+                _add(any_branch, map);
+            else if (lr.shallowest == BRANCH_END)
+                _add(branch_end[lr.branch], map);
+            else
+            {
+                for (int d = max(lr.shallowest, 1);
+                     d <= min(lr.deepest, MAX_BRANCH_DEPTH); ++d)
+                {
+                    _add(by_depth[lr.branch][d], map);
+                }
+            }
+        }
+    }
+
+    // Returns false if the place can't be looked up, in which case every
+    // map has to be considered.
+    bool candidates(const level_id &place, vault_indices &maps) const
+    {
+        if (place.branch < 0 || place.branch >= NUM_BRANCHES
+            || place.depth < 1 || place.depth > MAX_BRANCH_DEPTH)
+        {
+            return false;
+        }
+
+        vault_indices both;
+        const vault_indices &here = by_depth[place.branch][place.depth];
+        const vault_indices &end = branch_end[place.branch];
+        set_union(here.begin(), here.end(), end.begin(), end.end(),
+                  back_inserter(both));
+        maps.clear();
+        set_union(both.begin(), both.end(),
+                  any_branch.begin(), any_branch.end(),
+                  back_inserter(maps));
+        return true;
+    }
+
+private:
+    // Maps are added in vdefs order, so this keeps the lists sorted.
+    static void _add(vault_indices &maps, unsigned map)
+    {
+        if (maps.empty() || maps.back() != map)
+            maps.push_back(map);
+    }
+};
+
+// Inverted indices over vdefs, so that map selection only has to look at
+// maps that can match, rather than every map. Rebuilt on demand whenever
+// maps are loaded or changed.
+static bool map_index_valid = false;
+static unordered_map<string, unsigned> map_tag_ids;
+static vector<vault_indices> maps_by_tag;
+static map_depth_index maps_by_depth;
+static map_depth_index maps_by_place;
+
+static void _build_map_index()
+{
+    map_tag_ids.clear();
+    maps_by_tag.clear();
+    maps_by_depth.clear();
+    maps_by_place.clear();
+
+    for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+    {
+        const map_def &mapdef = vdefs[i];
+        for (const string &tag : mapdef.get_tags())
+        {
+            auto id = map_tag_ids.emplace(tag, maps_by_tag.size());
+            if (id.second)
+                maps_by_tag.emplace_back();
+            vault_indices &maps = maps_by_tag[id.first->second];
+            if (maps.empty() || maps.back() != i)
+                maps.push_back(i);
+        }
+        maps_by_depth.add(i, mapdef.depths);
+        maps_by_place.add(i, mapdef.place);
+    }
+
+    map_index_valid = true;
+}
+
+static void _check_map_index()
+{
+    if (!map_index_valid)
+        _build_map_index();
+}
+
+void map_def_changed(const map_def *map)
+{
+    // Only the maps in vdefs are indexed; vaults being placed are copies.
+    if (!vdefs.empty() && map >= &vdefs.front() && map <= &vdefs.back())
+        map_index_valid = false;
+}
+
+// The maps carrying all of the given space-separated tags.
+static vault_indices _maps_with_tags(const string &tags)
+{
+    _check_map_index();
+
+    vault_indices maps;
+    bool first = true;
+    for (const string &tag : split_string(" ", tags))
+    {
+        auto id = map_tag_ids.find(tag);
+        if (id == map_tag_ids.end())
+            return vault_indices();
+
+        const vault_indices &tagged = maps_by_tag[id->second];
+        if (first)
+            maps = tagged;
+        else
+        {
+            vault_indices both;
+            set_intersection(maps.begin(), maps.end(),
+                             tagged.begin(), tagged.end(),
+                             back_inserter(both));
+            maps.swap(both);
+        }
+        first = false;
+    }
+    return maps;
+}
+
+// Narrow down maps to those that also carry tag.
+static void _filter_by_tag(vault_indices &maps, const string &tag)
+{
+    const vault_indices tagged = _maps_with_tags(tag);
+    vault_indices both;
+    set_intersection(maps.begin(), maps.end(), tagged.begin(), tagged.end(),
+                     back_inserter(both));
+    maps.swap(both);
+}
+
 mapref_vector find_maps_for_tag(const string &tag,
                                 bool check_depth,
                                 bool check_used)
@@ -721,8 +886,9 @@ mapref_vector find_maps_for_tag(const string &tag,
     mapref_vector maps;
     level_id place = level_id::current();
 
-    for (const map_def &mapdef : vdefs)
+    for (unsigned i : _maps_with_tags(tag))
     {
+        const map_def &mapdef = vdefs[i];
         if (mapdef.has_tag(tag)
             && !mapdef.has_tag("dummy")
             && (!check_depth || !mapdef.has_depth()
@@ -748,6 +914,7 @@ private:
 
 public:
     bool accept(const map_def &md) const;
+    bool candidates(vault_indices &maps) const;
     void announce(const map_def *map) const;
 
     bool valid() const
@@ -890,6 +1057,40 @@ bool map_selector::accept(const map_def &mapdef) const
     }
 }
 
+// Find the maps that accept() might take, from the map indices. Returns
+// false if every map has to be checked.
+bool map_selector::candidates(vault_indices &maps) const
+{
+    switch (sel)
+    {
+    case PLACE:
+        if (!maps_by_place.candidates(place, maps))
+            return false;
+        if (mini)
+            _filter_by_tag(maps, "minivault");
+        break;
+
+    case DEPTH:
+    case DEPTH_AND_CHANCE:
+        if (!maps_by_depth.candidates(place, maps))
+            return false;
+        if (sel == DEPTH && mini)
+            _filter_by_tag(maps, "minivault");
+        break;
+
+    case TAG:
+        maps = _maps_with_tags(tag);
+        break;
+
+    default:
+        return false;
+    }
+
+    if (extra == MB_TRUE)
+        _filter_by_tag(maps, "extra");
+    return true;
+}
+
 void map_selector::announce(const map_def *vault) const
 {
 #ifdef DEBUG_DIAGNOSTICS
@@ -928,17 +1129,27 @@ string vault_chance_tag(const map_def &map)
     return "";
 }
 
-typedef vector<unsigned> vault_indices;
-
 static vault_indices _eligible_maps_for_selector(const map_selector &sel)
 {
     vault_indices eligible;
 
     if (sel.valid())
     {
-        for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
-            if (sel.accept(vdefs[i]))
-                eligible.push_back(i);
+        _check_map_index();
+
+        vault_indices maps;
+        if (sel.candidates(maps))
+        {
+            for (unsigned i : maps)
+                if (sel.accept(vdefs[i]))
+                    eligible.push_back(i);
+        }
+        else
+        {
+            for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+                if (sel.accept(vdefs[i]))
+                    eligible.push_back(i);
+        }
     }
 
     return eligible;
@@ -1299,6 +1510,7 @@ static bool _load_map_index(const string& cache, const string &base,
     const int nmaps = unmarshallShort(inf);
     const int nexist = vdefs.size();
     vdefs.resize(nexist + nmaps, map_def());
+    map_index_valid = false;
     for (int i = 0; i < nmaps; ++i)
     {
         map_def &vdef(vdefs[nexist + i]);
@@ -1483,6 +1695,8 @@ void reread_maps()
 
     // BOOM!
     vdefs.clear();
+    map_index_valid = false;
+    clear_map_body_cache();
     map_files_read.clear();
     read_maps();
 }
@@ -1502,6 +1716,7 @@ void add_parsed_map(const map_def &md)
 
     map.fixup();
     vdefs.push_back(map);
+    map_index_valid = false;
 }
 
 void run_map_global_preludes()
@@ -53,6 +53,8 @@ vector<string> find_map_matches(const string &name);
 mapref_vector find_maps_for_tag(const string &tag,
                                 bool check_depth = false,
                                 bool check_used = true);
+// Call after changing the tags or depths of a loaded map.
+void map_def_changed(const map_def *map);
 
 void read_maps();
 void reread_maps();
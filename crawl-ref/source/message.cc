@@ -1144,23 +1144,109 @@ void dprf(diag_type param, const char *format, ...)
 
 static bool _updating_view = false;
 
-static bool _check_option(const string& line, msg_channel_type channel,
-                          const vector<message_filter>& option)
+// The message filters of one option, with the patterns which apply to each
+// channel compiled together the first time a message on that channel is
+// checked. Everything is rebuilt if the option changes.
+class message_filter_set
 {
-    return any_of(begin(option),
-                  end(option),
-                  bind(mem_fn(&message_filter::is_filtered),
-                       placeholders::_1, channel, line));
+public:
+    // Use these filters; cheap if they are the ones already in use.
+    template<class T>
+    void set_filters(const vector<T> &list,
+                     const message_filter &(*get)(const T &))
+    {
+        bool same = list.size() == filters.size();
+        for (size_t i = 0; same && i < list.size(); ++i)
+            same = get(list[i]) == filters[i];
+        if (same)
+            return;
+
+        filters.clear();
+        for (const T &entry : list)
+            filters.push_back(get(entry));
+        for (channel_filters &chan : channels)
+            chan.built = false;
+    }
+
+    // The index of the first filter matching this message, or -1.
+    int first_match(msg_channel_type channel, const string &line)
+    {
+        const channel_filters &chan = _channel(channel);
+        const int found = chan.patterns.first_match(line);
+        return found == -1 ? chan.unconditional : chan.index[found];
+    }
+
+    bool matches(msg_channel_type channel, const string &line)
+    {
+        const channel_filters &chan = _channel(channel);
+        return chan.unconditional != -1 || chan.patterns.matches(line);
+    }
+
+private:
+    struct channel_filters
+    {
+        bool built = false;
+        // The filter each pattern came from.
+        vector<int> index;
+        // The first filter matching anything on this channel, or -1. Only
+        // the filters before it need to be checked.
+        int unconditional = -1;
+        pattern_set patterns;
+    };
+
+    const channel_filters &_channel(msg_channel_type channel)
+    {
+        channel_filters &chan = channels[channel];
+        if (chan.built)
+            return chan;
+
+        vector<text_pattern> pats;
+        chan.index.clear();
+        chan.unconditional = -1;
+        for (size_t i = 0; i < filters.size(); ++i)
+        {
+            const message_filter &filter = filters[i];
+            if (filter.channel != channel && filter.channel != -1)
+                continue;
+            if (filter.pattern.empty())
+            {
+                chan.unconditional = i;
+                break;
+            }
+            pats.push_back(filter.pattern);
+            chan.index.push_back(i);
+        }
+        chan.patterns.set_patterns(pats);
+        chan.built = true;
+        return chan;
+    }
+
+    vector<message_filter> filters;
+    channel_filters channels[NUM_MESSAGE_CHANNELS];
+};
+
+static const message_filter &_filter_itself(const message_filter &filter)
+{
+    return filter;
+}
+
+static const message_filter &_colour_filter(const message_colour_mapping &mcm)
+{
+    return mcm.message;
 }
 
 static bool _check_more(const string& line, msg_channel_type channel)
 {
-    return _check_option(line, channel, Options.force_more_message);
+    static message_filter_set filters;
+    filters.set_filters(Options.force_more_message, _filter_itself);
+    return filters.matches(channel, line);
 }
 
 static bool _check_flash_screen(const string& line, msg_channel_type channel)
 {
-    return _check_option(line, channel, Options.flash_screen_message);
+    static message_filter_set filters;
+    filters.set_filters(Options.flash_screen_message, _filter_itself);
+    return filters.matches(channel, line);
 }
 
 static bool _check_join(const string& line, msg_channel_type channel)
@@ -1440,21 +1526,15 @@ static void mpr_check_patterns(const string& message,
                                msg_channel_type channel,
                                int param)
 {
-    for (const text_pattern &pat : Options.note_messages)
+    static pattern_set note_messages;
+    note_messages.set_patterns(Options.note_messages);
+    if (channel != MSGCH_EQUIPMENT && channel != MSGCH_FLOOR_ITEMS
+        && channel != MSGCH_MULTITURN_ACTION
+        && channel != MSGCH_EXAMINE && channel != MSGCH_EXAMINE_FILTER
+        && channel != MSGCH_TUTORIAL && channel != MSGCH_DGL_MESSAGE
+        && note_messages.matches(message))
     {
-        if (channel == MSGCH_EQUIPMENT || channel == MSGCH_FLOOR_ITEMS
-            || channel == MSGCH_MULTITURN_ACTION
-            || channel == MSGCH_EXAMINE || channel == MSGCH_EXAMINE_FILTER
-            || channel == MSGCH_TUTORIAL || channel == MSGCH_DGL_MESSAGE)
-        {
-            continue;
-        }
-
-        if (pat.matches(message))
-        {
-            take_note(Note(NOTE_MESSAGE, channel, param, message));
-            break;
-        }
+        take_note(Note(NOTE_MESSAGE, channel, param, message));
     }
 
     if (channel != MSGCH_DIAGNOSTICS && channel != MSGCH_EQUIPMENT)
@@ -1507,14 +1587,11 @@ static msg_colour_type prepare_message(const string& imsg,
     if (colour != MSGCOL_MUTED)
         mpr_check_patterns(imsg, channel, param);
 
-    for (const message_colour_mapping &mcm : Options.message_colour_mappings)
-    {
-        if (mcm.message.is_filtered(channel, imsg))
-        {
-            colour = mcm.colour;
-            break;
-        }
-    }
+    static message_filter_set colour_filters;
+    colour_filters.set_filters(Options.message_colour_mappings, _colour_filter);
+    const int mapping = colour_filters.first_match(channel, imsg);
+    if (mapping != -1)
+        colour = Options.message_colour_mappings[mapping].colour;
 
     return colour;
 }
@@ -43,6 +43,7 @@
 #include "mon-cast.h"
 #include "mon-death.h"
 #include "mon-movetarget.h"
+#include "mon-pathfind.h"
 #include "mon-place.h"
 #include "mon-project.h"
 #include "mon-speak.h"
@@ -2581,13 +2582,25 @@ static void _update_monster_attitude(monster *mon)
  */
 void handle_monsters(bool with_noise)
 {
+    vector<coord_def> sources;
     for (monster_iterator mi; mi; ++mi)
     {
         _pre_monster_move(**mi);
         if (!invalid_monster(*mi) && mi->alive() && mi->has_action_energy())
+        {
             monster_queue.emplace(*mi, mi->speed_increment);
+            sources.push_back(mi->pos());
+        }
     }
 
+    // Every acting monster is about to look around; compute their fields
+    // together, so that crowded levels (the arena especially) share one
+    // pass over the map between them.
+    cache_los_fields(sources, LOS_DEFAULT);
+
+    // Paths shared between monsters are only good for one turn.
+    invalidate_flow_fields();
+
     int tries = 0; // infinite loop protection, shouldn't be ever needed
     while (!monster_queue.empty())
     {
@@ -2489,6 +2489,7 @@ static bool _seal_doors_and_stairs(const monster* warden,
                     if (env.map_knowledge(dc).seen())
                     {
                         env.map_knowledge(dc).set_feature(DNGN_CLOSED_DOOR);
+                        update_travel_region_cell(dc);
 #ifdef USE_TILE
                         env.tile_bk_bg(dc) = TILE_DNGN_CLOSED_DOOR;
 #endif
@@ -4040,6 +4041,9 @@ static mon_spell_slot _choose_spell_to_cast(monster &mons,
                                             const monster_spells &hspell_pass,
                                             bool ignore_good_idea)
 {
+    // The same spell may be traced more than once while choosing.
+    tracer_cache_scope tracers;
+
     // Monsters caught in a net try to get away.
     // This is only urgent if enemies are around.
     if (mon_enemies_around(&mons) && mons.caught() && one_chance_in(15))
@@ -224,7 +224,7 @@ bool try_pathfind(monster* mon)
     if (range > 0)
         mp.set_range(range);
 
-    if (mp.init_pathfind(mon, targpos))
+    if (mp.init_flow_pathfind(mon, targpos))
     {
         mon->travel_path = mp.calc_waypoints();
         if (!mon->travel_path.empty())
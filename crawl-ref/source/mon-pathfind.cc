@@ -2,11 +2,14 @@
 
 #include "mon-pathfind.h"
 
+#include <algorithm>
+
 #include "directn.h"
 #include "env.h"
 #include "los.h"
 #include "mon-movetarget.h"
 #include "mon-place.h"
+#include "mon-tentacle.h"
 #include "religion.h"
 #include "state.h"
 #include "terrain.h"
@@ -18,17 +21,71 @@
 // The pathfinding is an implementation of the A* algorithm. Beginning at the
 // monster position we check all neighbours of a given grid, estimate the
 // distance needed for any shortest path including this grid and push the
-// result into a hash. We can then easily access all points with the shortest
-// distance estimates and then check _their_ neighbours and so on.
+// result into a binary heap. We can then easily access the point with the
+// shortest distance estimate and then check _its_ neighbours and so on.
+// Among points with equal estimates, the one most recently pushed comes
+// first, as it's most likely to be close to the target.
 // The algorithm terminates once we reach the destination since - because
-// of the sorting of grids by shortest distance in the hash - there can be no
+// of the sorting of grids by shortest distance in the heap - there can be no
 // path between start and target that is shorter than the current one. There
 // could be other paths that have the same length but that has no real impact.
-// If the hash has been cleared and the start grid has not been encountered,
+// If the heap has been emptied and the start grid has not been encountered,
 // then there's no path that matches the requirements fed into monster_pathfind.
 // (These requirements are usually preference of habitat of a specific monster
 // or a limit of the distance between start and any grid on the path.)
 
+struct pathfind_node
+{
+    int total;          // Estimated total path length through pos.
+    unsigned int seq;   // Order of insertion, for tie-breaking.
+    coord_def pos;
+
+    // Heap order: the "largest" node is the one to expand next.
+    bool operator<(const pathfind_node& other) const
+    {
+        if (total != other.total)
+            return total > other.total;
+        return seq < other.seq;
+    }
+};
+
+struct pathfind_context
+{
+    // dist and prev are only valid where stamp equals generation, so
+    // starting a new search just needs a new generation.
+    unsigned int generation;
+    unsigned int seq;
+    unsigned int stamp[GXM][GYM];
+    // Distances from the start to any already tried point.
+    int dist[GXM][GYM];
+    // Where we came from on a given shortest path.
+    int8_t prev[GXM][GYM];
+    // Points still to be expanded. Entries superseded by a shorter path
+    // are left in place and skipped when they come up.
+    vector<pathfind_node> open;
+
+    pathfind_context() : generation(0), seq(0)
+    {
+        memset(stamp, 0, sizeof(stamp));
+    }
+
+    void reset()
+    {
+        if (++generation == 0)
+        {
+            memset(stamp, 0, sizeof(stamp));
+            generation = 1;
+        }
+        seq = 0;
+        open.clear();
+    }
+};
+
+// Contexts not currently owned by a monster_pathfind. Searches can nest
+// (e.g. a monster's move may need another path), so this can hold more
+// than one.
+static vector<pathfind_context*> pathfind_pool;
+
 int mons_tracking_range(const monster* mon)
 {
     int range = 0;
@@ -67,13 +124,21 @@ int mons_tracking_range(const monster* mon)
 //#define DEBUG_PATHFIND
 monster_pathfind::monster_pathfind()
     : mons(nullptr), start(), target(), pos(), allow_diagonals(true),
-      traverse_unmapped(false), range(0), min_length(0), max_length(0),
-      dist(), prev(), hash()
+      traverse_unmapped(false), range(0), ctx(nullptr)
 {
+    if (pathfind_pool.empty())
+        ctx = new pathfind_context;
+    else
+    {
+        ctx = pathfind_pool.back();
+        pathfind_pool.pop_back();
+    }
+    ctx->reset();
 }
 
 monster_pathfind::~monster_pathfind()
 {
+    pathfind_pool.push_back(ctx);
 }
 
 void monster_pathfind::set_range(int r)
@@ -84,7 +149,20 @@ void monster_pathfind::set_range(int r)
 
 coord_def monster_pathfind::next_pos(const coord_def &c) const
 {
-    return c + Compass[prev[c.x][c.y]];
+    return c + Compass[ctx->prev[c.x][c.y]];
+}
+
+int monster_pathfind::get_dist(const coord_def& p) const
+{
+    return ctx->stamp[p.x][p.y] == ctx->generation ? ctx->dist[p.x][p.y]
+                                                   : INFINITE_DISTANCE;
+}
+
+void monster_pathfind::set_dist(const coord_def& p, int d, int from_dir)
+{
+    ctx->stamp[p.x][p.y] = ctx->generation;
+    ctx->dist[p.x][p.y] = d;
+    ctx->prev[p.x][p.y] = from_dir;
 }
 
 // The main method in the monster_pathfind class.
@@ -139,18 +217,14 @@ bool monster_pathfind::start_pathfind(bool msg)
     //       surrounded by shallow water or floor, or if a foe is hiding in
     //       a wall.
 
-    max_length = min_length = grid_distance(pos, target);
-    for (int i = 0; i < GXM; i++)
-        for (int j = 0; j < GYM; j++)
-            dist[i][j] = INFINITE_DISTANCE;
-
-    dist[pos.x][pos.y] = 0;
+    ctx->reset();
+    set_dist(pos, 0, 0);
 
     bool success = false;
     do
     {
         // Calculate the distance to all neighbours of the current position,
-        // and add them to the hash, if they haven't already been looked at.
+        // and add them to the heap, if they haven't already been looked at.
         success = calc_path_to_neighbours();
         if (success)
             return true;
@@ -214,8 +288,8 @@ bool monster_pathfind::calc_path_to_neighbours()
         if (range && estimated_cost(npos) > range)
             continue;
 
-        distance = dist[pos.x][pos.y] + travel_cost(npos);
-        old_dist = dist[npos.x][npos.y];
+        distance = get_dist(pos) + travel_cost(npos);
+        old_dist = get_dist(npos);
 
         // Also bail out if this would make the path longer than twice the
         // allowed distance from the target. (This factor may need tuning.)
@@ -243,12 +317,10 @@ bool monster_pathfind::calc_path_to_neighbours()
             if (old_dist == INFINITE_DISTANCE)
             {
 #ifdef DEBUG_PATHFIND
-                mprf("Adding (%d,%d) to hash (total dist = %d)",
+                mprf("Adding (%d,%d) to heap (total dist = %d)",
                      npos.x, npos.y, total);
 #endif
                 add_new_pos(npos, total);
-                if (total > max_length)
-                    max_length = total;
             }
             else
             {
@@ -260,16 +332,13 @@ bool monster_pathfind::calc_path_to_neighbours()
                 update_pos(npos, total);
             }
 
-            // Update distance start->pos.
-            dist[npos.x][npos.y] = distance;
-
-            // Set backtracking information.
+            // Update distance start->pos, and set backtracking information.
             // Converts the Compass direction to its counterpart.
             //      0  1  2         4  5  6
             //      7  .  3   ==>   3  .  7       e.g. (3 + 4) % 8          = 7
             //      6  5  4         2  1  0            (7 + 4) % 8 = 11 % 8 = 3
 
-            prev[npos.x][npos.y] = (dir + 4) % 8;
+            set_dist(npos, distance, (dir + 4) % 8);
 
             // Are we finished?
             if (npos == target)
@@ -284,34 +353,27 @@ bool monster_pathfind::calc_path_to_neighbours()
     return false;
 }
 
-// Starting at known min_length (minimum total estimated path distance), check
-// the hash for existing vectors, then pick the last entry of the first vector
-// that matches. Update min_length, if necessary.
+// Pop the position with the shortest total estimated path distance from the
+// heap, skipping entries for positions that have since been reached by a
+// shorter path.
 bool monster_pathfind::get_best_position()
 {
-    for (int i = min_length; i <= max_length; i++)
+    vector<pathfind_node> &open = ctx->open;
+    while (!open.empty())
     {
-        if (!hash[i].empty())
-        {
-            if (i > min_length)
-                min_length = i;
-
-            vector<coord_def> &vec = hash[i];
-            // Pick the last position pushed into the vector as it's most
-            // likely to be close to the target.
-            pos = vec[vec.size()-1];
-            vec.pop_back();
+        pop_heap(open.begin(), open.end());
+        const pathfind_node node = open.back();
+        open.pop_back();
 
-#ifdef DEBUG_PATHFIND
-            mprf("Returning (%d, %d) as best pos with total dist %d.",
-                 pos.x, pos.y, min_length);
-#endif
+        if (node.total != get_dist(node.pos) + estimated_cost(node.pos))
+            continue;
 
-            return true;
-        }
+        pos = node.pos;
 #ifdef DEBUG_PATHFIND
-        mprf("No positions for path length %d.", i);
+        mprf("Returning (%d, %d) as best pos with total dist %d.",
+             pos.x, pos.y, node.total);
 #endif
+        return true;
     }
 
     // Nothing found? Then there's no path! :(
@@ -335,7 +397,7 @@ vector<coord_def> monster_pathfind::backtrack()
     int dir;
     do
     {
-        dir = prev[pos.x][pos.y];
+        dir = ctx->prev[pos.x][pos.y];
         pos = pos + Compass[dir];
         ASSERT_IN_BOUNDS(pos);
 #ifdef DEBUG_PATHFIND
@@ -501,24 +563,277 @@ int monster_pathfind::estimated_cost(coord_def p)
 
 void monster_pathfind::add_new_pos(coord_def npos, int total)
 {
-    hash[total].push_back(npos);
+    ctx->open.push_back({ total, ctx->seq++, npos });
+    push_heap(ctx->open.begin(), ctx->open.end());
 }
 
 void monster_pathfind::update_pos(coord_def npos, int total)
 {
-    // Find hash position of old distance and delete it,
-    // then call_add_new_pos.
-    int old_total = dist[npos.x][npos.y] + estimated_cost(npos);
+    // The old entry stays in the heap, but will no longer match the
+    // distance to npos once the caller updates it, and so be skipped.
+    add_new_pos(npos, total);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Shared flow fields
+//
+// When a crowd of hostiles chases the same foe, most of them search the same
+// area under the same rules. The first monster of a traversal class to ask
+// does its own A* search as usual; once a second one asks, a single Dijkstra
+// search is run outward from the target, and everyone else of that class
+// reads their path off the result.
+
+// Everything traversable() and travel_cost() look at for a monster that
+// passes _can_share_flow(). Monsters with equal classes get equal paths.
+struct flow_class
+{
+    coord_def target;
+    int range;
+    // Habitat of the (zombie-fixed) type, for habitability.
+    habitat_type habitat;
+    habitat_type secondary_habitat;
+    // The monster's own habitats, for floundering.
+    habitat_type own_habitat;
+    habitat_type real_habitat;
+    bool airborne;
+    bool ground_level;
+    bool balanced_shallow;
+    bool balanced_deep;
+    bool doors;
+    // Trap knowledge.
+    mon_intel_type intel;
+    bool native;
+
+    bool operator==(const flow_class& other) const
+    {
+        return target == other.target
+               && range == other.range
+               && habitat == other.habitat
+               && secondary_habitat == other.secondary_habitat
+               && own_habitat == other.own_habitat
+               && real_habitat == other.real_habitat
+               && airborne == other.airborne
+               && ground_level == other.ground_level
+               && balanced_shallow == other.balanced_shallow
+               && balanced_deep == other.balanced_deep
+               && doors == other.doors
+               && intel == other.intel
+               && native == other.native;
+    }
+};
+
+struct flow_field
+{
+    flow_class cls;
+    // How many monsters of this class have asked so far this turn.
+    int requests;
+    // The cells a monster may start from or step through.
+    coord_def tl, br;
+    // Cost of the cheapest path to the target, and the first step on it.
+    vector<int> dist;
+    vector<int8_t> next;
+
+    bool built() const
+    {
+        return !dist.empty();
+    }
+
+    bool contains(const coord_def& p) const
+    {
+        return p.x >= tl.x && p.y >= tl.y && p.x <= br.x && p.y <= br.y;
+    }
+
+    int index(const coord_def& p) const
+    {
+        return (p.y - tl.y) * (br.x - tl.x + 1) + p.x - tl.x;
+    }
+};
+
+// Classes asked for since the last monster turn began, with the fields built
+// for those asked for more than once; discarded wholesale at the start of
+// each turn and piecemeal when terrain they cover changes.
+#define MAX_FLOW_FIELDS 32
+static vector<flow_field> flow_fields;
+
+void invalidate_flow_fields()
+{
+    flow_fields.clear();
+}
+
+void invalidate_flow_fields_at(const coord_def& p)
+{
+    flow_fields.erase(remove_if(flow_fields.begin(), flow_fields.end(),
+                                [&p](const flow_field &f)
+                                { return f.contains(p); }),
+                      flow_fields.end());
+}
+
+// Monsters whose pathing doesn't depend on anything but their class and the
+// terrain. Allies follow the player's rules about traps and sight, clinging
+// depends on where the monster is, and a few species get special cases in
+// traversable() or habitability.
+static bool _can_share_flow(const monster* mon)
+{
+    const monster_type base = mons_base_type(*mon);
+    const monster_type mt = fixup_zombie_type(mon->type, base);
+
+    return !mon->wont_attack()
+           && !mon->can_cling_to_walls()
+           && !mons_is_tentacle_segment(base)
+           && mt != MONS_KRAKEN
+           && mt != MONS_ELDRITCH_TENTACLE
+           && mt != MONS_ELDRITCH_TENTACLE_SEGMENT
+           && base != MONS_ELDRITCH_TENTACLE
+           && mon->type != MONS_THORN_HUNTER
+           && mon->type != MONS_WANDERING_MUSHROOM;
+}
+
+static flow_class _flow_class(const monster* mon, const coord_def& target,
+                              int range)
+{
+    const monster_type base = mons_base_type(*mon);
+    const monster_type mt = fixup_zombie_type(mon->type, base);
+
+    flow_class cls;
+    cls.target            = target;
+    cls.range             = range;
+    cls.habitat           = mons_class_primary_habitat(mt);
+    cls.secondary_habitat = mons_class_secondary_habitat(mt);
+    cls.own_habitat       = mons_primary_habitat(*mon);
+    cls.real_habitat      = mons_habitat(*mon, true);
+    cls.airborne          = mon->airborne();
+    cls.ground_level      = mon->ground_level();
+    cls.balanced_shallow  = mon->extra_balanced_on(DNGN_SHALLOW_WATER);
+    cls.balanced_deep     = mon->extra_balanced_on(DNGN_DEEP_WATER);
+    cls.doors             = mons_itemuse(*mon) >= MONUSE_OPEN_DOORS
+                            || mons_eats_items(*mon)
+                            || mons_class_flag(base, M_EAT_DOORS)
+                            || mons_class_flag(base, M_CRASH_DOORS);
+    cls.intel             = mons_intel(*mon);
+    cls.native            = mons_is_native_in_branch(*mon);
+    return cls;
+}
+
+// Like init_pathfind(), but for a hostile monster chasing its foe: reads the
+// path off the shared flow field for its class, building it if another
+// monster of the class already asked. Falls back to a private search for
+// the first monster of a class, and for monsters that can't share. Without
+// a tracking range a field would cover the whole level, so those don't
+// share either.
+bool monster_pathfind::init_flow_pathfind(const monster* mon, coord_def dest)
+{
+    if (!_can_share_flow(mon) || !range)
+        return init_pathfind(mon, dest);
+
+    mons   = mon;
+    start  = mon->pos();
+    target = dest;
+    pos    = start;
+    allow_diagonals   = true;
+    traverse_unmapped = false;
+    traverse_in_sight = false;
 
-    vector<coord_def> &vec = hash[old_total];
-    for (unsigned int i = 0; i < vec.size(); i++)
+    if (start == target)
+        return true;
+
+    const flow_class cls = _flow_class(mon, dest, range);
+    auto it = find_if(flow_fields.begin(), flow_fields.end(),
+                      [&cls](const flow_field &f) { return f.cls == cls; });
+    if (it == flow_fields.end())
     {
-        if (vec[i] == npos)
+        if (flow_fields.size() >= MAX_FLOW_FIELDS)
+            flow_fields.clear();
+        flow_fields.emplace_back();
+        flow_fields.back().cls = cls;
+        flow_fields.back().requests = 1;
+        return start_pathfind();
+    }
+
+    flow_field &field = *it;
+    ++field.requests;
+    if (!field.built())
+        fill_flow_field(field);
+
+    if (!field.contains(start))
+        return start_pathfind();
+
+    const int total = field.dist[field.index(start)];
+    if (total == INFINITE_DISTANCE)
+        return false;
+
+    // Lay the path out as start_pathfind() would have, so that backtrack()
+    // and calc_waypoints() work as usual.
+    ctx->reset();
+    set_dist(start, 0, 0);
+    for (coord_def p = start; p != target;)
+    {
+        const int dir = field.next[field.index(p)];
+        const coord_def np = p + Compass[dir];
+        set_dist(np, total - field.dist[field.index(np)], (dir + 4) % 8);
+        p = np;
+    }
+    return true;
+}
+
+// Dijkstra's algorithm, run backwards from the target: the cost of a path
+// from any cell in range, stepping only on cells the monster could enter,
+// under the same limits as calc_path_to_neighbours().
+void monster_pathfind::fill_flow_field(flow_field &field)
+{
+    ASSERT(range);
+    field.tl = coord_def(max(target.x - range, 0), max(target.y - range, 0));
+    field.br = coord_def(min(target.x + range, GXM - 1),
+                         min(target.y + range, GYM - 1));
+
+    ctx->reset();
+    set_dist(target, 0, 0);
+    add_new_pos(target, 0);
+
+    vector<pathfind_node> &open = ctx->open;
+    while (!open.empty())
+    {
+        pop_heap(open.begin(), open.end());
+        const pathfind_node node = open.back();
+        open.pop_back();
+
+        if (node.total != get_dist(node.pos))
+            continue;
+
+        // Every neighbour reaches the target by stepping onto pos first.
+        pos = node.pos;
+        const int distance = node.total + travel_cost(pos);
+        if (range && distance > range * 2)
+            continue;
+
+        // Diagonals first, as in calc_path_to_neighbours(), so that
+        // orthogonal steps win ties; but always from the same direction,
+        // so that building a field uses no randomness.
+        for (int dir = 1; dir < 8; (dir += 2) == 9 && (dir = 0))
         {
-            vec.erase(vec.begin() + i);
-            break;
+            const coord_def npos = pos + Compass[dir];
+
+            if (!in_bounds(npos) || !field.contains(npos)
+                || distance >= get_dist(npos))
+            {
+                continue;
+            }
+
+            // The first step from npos leads back to pos.
+            set_dist(npos, distance, (dir + 4) % 8);
+            if (traversable(npos))
+                add_new_pos(npos, distance);
         }
     }
 
-    add_new_pos(npos, total);
+    const int size = (field.br.x - field.tl.x + 1)
+                     * (field.br.y - field.tl.y + 1);
+    field.dist.resize(size);
+    field.next.resize(size);
+    for (int y = field.tl.y; y <= field.br.y; ++y)
+        for (int x = field.tl.x; x <= field.br.x; ++x)
+        {
+            const coord_def p(x, y);
+            field.dist[field.index(p)] = get_dist(p);
+            field.next[field.index(p)] = ctx->prev[x][y];
+        }
 }
@@ -2,8 +2,12 @@
 #define MON_PATHFIND_H
 
 class monster;
+struct pathfind_context;
+struct flow_field;
 
 int mons_tracking_range(const monster* mon);
+void invalidate_flow_fields();
+void invalidate_flow_fields_at(const coord_def& p);
 
 class monster_pathfind
 {
@@ -11,6 +15,10 @@ public:
     monster_pathfind();
     virtual ~monster_pathfind();
 
+    // Each pathfinder owns a pooled context for the duration of its life.
+    monster_pathfind(const monster_pathfind&) = delete;
+    monster_pathfind& operator=(const monster_pathfind&) = delete;
+
     // public methods
     void set_range(int r);
     coord_def next_pos(const coord_def &p) const;
@@ -19,6 +27,7 @@ public:
                        bool pass_unmapped = false);
     bool init_pathfind(coord_def src, coord_def dest,
                        bool diag = true, bool msg = false);
+    bool init_flow_pathfind(const monster* mon, coord_def dest);
     bool start_pathfind(bool msg = false);
     vector<coord_def> backtrack();
     vector<coord_def> calc_waypoints();
@@ -34,6 +43,9 @@ protected:
     void add_new_pos(coord_def pos, int total);
     void update_pos(coord_def pos, int total);
     bool get_best_position();
+    void fill_flow_field(flow_field &field);
+    int  get_dist(const coord_def& p) const;
+    void set_dist(const coord_def& p, int d, int from_dir);
 
     // The monster trying to find a path.
     const monster* mons;
@@ -56,16 +68,9 @@ protected:
     // Maximum range to search between start and target. None, if zero.
     int range;
 
-    // Currently shortest and longest possible total length of the path.
-    int min_length;
-    int max_length;
-
-    // The array of distances from start to any already tried point.
-    int dist[GXM][GYM];
-    // An array to store where we came from on a given shortest path.
-    int prev[GXM][GYM];
-
-    FixedVector<vector<coord_def>, GXM * GYM> hash;
+    // Distances from the start, backtracking information and the open
+    // set, borrowed from a pool and reset in constant time per search.
+    pathfind_context* ctx;
 };
 
 #endif
@@ -11,6 +11,7 @@
 #include <algorithm>
 
 #include "abyss.h"
+#include "act-iter.h"
 #include "areas.h"
 #include "arena.h"
 #include "attitude-change.h"
@@ -1178,6 +1179,7 @@ monster* get_free_monster()
         if (mons.type == MONS_NO_MONSTER)
         {
             mons.reset();
+            monster_index_update(mons);
             return &mons;
         }
 
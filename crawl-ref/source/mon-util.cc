@@ -4978,6 +4978,7 @@ void reset_all_monsters()
     }
 
     env.mid_cache.clear();
+    monster_index_clear();
 }
 
 bool mons_is_recallable(const actor* caller, const monster& targ)
@@ -5265,14 +5266,11 @@ bool mons_is_notable(const monster& mons)
         return false;
     if (mons_threat_level(mons) == MTHRT_NASTY)
         return true;
-    const auto &nm = Options.note_monsters;
+    static pattern_set note_monsters;
+    note_monsters.set_patterns(Options.note_monsters);
     // Don't waste time on moname() if user isn't using this option
-    if (!nm.empty())
-    {
-        const string iname = mons_type_name(mons.type, DESC_A);
-        return any_of(begin(nm), end(nm), [&](const text_pattern &pat) -> bool
-                                          { return pat.matches(iname); });
-    }
+    if (!note_monsters.empty())
+        return note_monsters.matches(mons_type_name(mons.type, DESC_A));
 
     return false;
 }
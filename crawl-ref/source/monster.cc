@@ -141,6 +141,7 @@ void monster::reset()
     unseen_pos = coord_def(0, 0);
 
     mons_remove_from_grid(*this);
+    monster_index_remove(*this);
     target.reset();
     position.reset();
     firing_pos.reset();
@@ -202,6 +203,8 @@ void monster::init_with(const monster& mon)
         ghost.reset(new ghost_demon(*mon.ghost));
     else
         ghost.reset(nullptr);
+
+    monster_index_update(*this);
 }
 
 uint32_t monster::last_client_id = 0;
@@ -258,7 +261,11 @@ bool monster::submerged() const
 
 bool monster::extra_balanced_at(const coord_def p) const
 {
-    const dungeon_feature_type grid = grd(p);
+    return extra_balanced_on(grd(p));
+}
+
+bool monster::extra_balanced_on(dungeon_feature_type grid) const
+{
     return (mons_genus(type) == MONS_DRACONIAN
             && draco_or_demonspawn_subspecies(*this) == MONS_GREY_DRACONIAN)
                 || grid == DNGN_SHALLOW_WATER
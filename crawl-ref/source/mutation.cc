@@ -1365,6 +1365,8 @@ bool mutate(mutation_type which_mutation, const string &reason, bool failMsg,
 
     bool gain_msg = true;
 
+    invalidate_autopickup_cache();
+
     while (count-- > 0)
     {
         you.mutation[mutat]++;
@@ -1559,6 +1561,7 @@ static bool _delete_single_mutation_level(mutation_type mutat,
     bool lose_msg = true;
 
     you.mutation[mutat]--;
+    invalidate_autopickup_cache();
 
     switch (mutat)
     {
@@ -119,7 +119,8 @@ public:
     // Propagate noise from the noise sources registered.
     void propagate_noise();
 
-    // Clear all noise from the noise grid.
+    // Clear all noise from the noise grid. Only the cells the last noises
+    // reached are cleared, so this is cheap for a grid that is mostly quiet.
     void reset();
 
     bool dirty() const { return !noises.empty(); }
@@ -145,10 +146,22 @@ private:
                                        const coord_def &affected_position,
                                        const noise_t &noise) const;
 
+    bool apply_noise_to_cell(const coord_def &pos,
+                             int noise_intensity_millis,
+                             int noise_id,
+                             int travel_distance,
+                             const coord_def &neighbour_delta);
+
 private:
     FixedArray<noise_cell, GXM, GYM> cells;
     vector<noise_t> noises;
     int affected_actor_count;
+
+    // Every cell which has been given a noise since the last reset.
+    vector<coord_def> touched_cells;
+    // The current and next rings of the propagating noise, kept between
+    // propagations so that their storage is reused.
+    vector<coord_def> noise_perimeter[2];
 };
 
 #endif
@@ -384,6 +384,8 @@ public:
     bool        read_persist_options; // If true, Crawl will try to load
                                       // options from c_persist.options
 
+    int         map_cache_size;     // Megabytes of vault code to keep loaded
+
     vector<text_pattern> drop_filter;
 
     map<string, FixedBitVector<NUM_AINTERRUPTS>> activity_interrupts;
@@ -523,6 +525,7 @@ public:
     string      tile_display_mode;
     bool        tile_level_map_hide_messages;
     bool        tile_level_map_hide_sidebar;
+    bool        tile_binary_map;
 #endif
 #endif // USE_TILE
 
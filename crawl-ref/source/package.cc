@@ -16,17 +16,27 @@ Notes:
 * Readers always get the last complete (but not necessarily committed) write
   (ie, READ_UNCOMMITTED) at the time they started; it is safe to continue
   reading even if the chunk has been changed since.
+* With ASYNC_SAVE, flush_async() hands queued chunks to a worker thread to
+  compress and write. The package belongs to that thread until it is joined,
+  which every other public entry point does first, so the above holds
+  unchanged. The commit itself always happens in commit(), on the caller's
+  thread, after the worker has been joined.
 */
 
 #include "AppHdr.h"
 
 #include "package.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <sstream>
 #include <fcntl.h>
+#ifdef USE_MMAP
+#include <sys/mman.h>
+#endif
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -35,6 +45,9 @@ Notes:
 #include "errors.h"
 #include "syscalls.h"
 #include "libutil.h" // map_find
+#ifdef ASYNC_SAVE
+#include "threads.h"
+#endif
 
 // debugging defines
 #undef  FSCK_VERBOSE
@@ -77,12 +90,28 @@ typedef map<string, plen_t> directory_t;
 typedef pair<plen_t, plen_t> bm_p;
 typedef map<plen_t, bm_p> bm_t;
 typedef map<plen_t, plen_t> fb_t;
+typedef vector<pair<string, vector<unsigned char> > > chunk_queue;
+
+#ifdef ASYNC_SAVE
+struct package::save_job
+{
+    thread_t thread;
+    chunk_queue chunks;
+    string error;
+};
+#endif
 
 package::package(const char* file, bool writeable, bool empty)
   : n_users(0), dirty(false), aborted(false)
 #ifdef DO_FSYNC
     , tmp(false)
 #endif
+#ifdef USE_MMAP
+    , map_base(nullptr), map_len(0)
+#endif
+#ifdef ASYNC_SAVE
+    , job(nullptr)
+#endif
 {
     dprintf("package: initializing file=\"%s\" rw=%d\n", file, writeable);
     ASSERT(writeable || !empty);
@@ -130,6 +159,12 @@ package::package()
 #ifdef DO_FSYNC
     , tmp(true)
 #endif
+#ifdef USE_MMAP
+    , map_base(nullptr), map_len(0)
+#endif
+#ifdef ASYNC_SAVE
+    , job(nullptr)
+#endif
 {
     dprintf("package: initializing tmp file\n");
     filename = "[tmp]";
@@ -208,12 +243,18 @@ package::~package()
         // catching missing manual deletes. The C++ exit handler is the
         // only place that can be legitimately call things in wrong order.
 
+#ifdef USE_MMAP
+    unmap_file();
+#endif
+
     if (rw && !aborted)
     {
         commit();
         if (ftruncate(fd, file_len))
             sysfail("failed to update save file");
     }
+    else
+        wait_for_job(false);
 
     // all errors here should be cached write errors
     if (fd != -1)
@@ -228,6 +269,7 @@ package::~package()
 void package::commit()
 {
     ASSERT(rw);
+    sync();
     if (!dirty)
         return;
     ASSERT(!aborted);
@@ -263,6 +305,141 @@ void package::commit()
 #endif
 }
 
+void package::write_async(const string &name, vector<unsigned char> &data)
+{
+    ASSERT(rw);
+    ASSERT(!aborted);
+    ASSERT(name.length() < MAX_CHUNK_NAME_LENGTH);
+    queued_chunks.emplace_back(name, vector<unsigned char>());
+    queued_chunks.back().second.swap(data);
+}
+
+// Start writing out the queued chunks. Without ASYNC_SAVE, or if the thread
+// can't be started, this does it all here.
+void package::flush_async()
+{
+    ASSERT(rw);
+#ifdef ASYNC_SAVE
+    wait_for_job(true);
+    if (queued_chunks.empty())
+        return;
+
+    job = new save_job;
+    job->chunks.swap(queued_chunks);
+    if (!thread_create_joinable(&job->thread, run_job, this))
+        return;
+
+    queued_chunks.swap(job->chunks);
+    delete job;
+    job = nullptr;
+#endif
+    sync();
+}
+
+// Finish any background work, then write out whatever is still queued.
+void package::sync()
+{
+    wait_for_job(true);
+    if (queued_chunks.empty())
+        return;
+
+    chunk_queue chunks;
+    chunks.swap(queued_chunks);
+    write_chunks(chunks);
+}
+
+void package::wait_for_job(bool report_errors)
+{
+#ifdef ASYNC_SAVE
+    if (!job)
+        return;
+
+    thread_join(job->thread);
+    const string error = job->error;
+    delete job;
+    job = nullptr;
+    if (report_errors && !error.empty())
+        fail("%s", error.c_str());
+#else
+    UNUSED(report_errors);
+#endif
+}
+
+#ifdef ASYNC_SAVE
+void *package::run_job(void *arg)
+{
+    package *pkg = static_cast<package*>(arg);
+    save_job *job = pkg->job;
+
+    // Errors can't be thrown across threads; hand them to whoever joins us.
+    try
+    {
+        pkg->write_chunks(job->chunks);
+    }
+    catch (exception &e)
+    {
+        job->error = e.what();
+        if (job->error.empty())
+            job->error = "error while saving";
+    }
+    return 0;
+}
+#endif
+
+void package::write_chunks(chunk_queue &chunks)
+{
+    for (auto &chunk : chunks)
+    {
+        {
+            chunk_writer cw(this, chunk.first);
+            if (!chunk.second.empty())
+                cw.write(&chunk.second[0], chunk.second.size());
+        }
+        // No need to hold on to the uncompressed copy any longer.
+        vector<unsigned char>().swap(chunk.second);
+    }
+}
+
+#ifdef USE_MMAP
+// Map the whole file as it is now. If that fails, readers just fall back
+// to read().
+void package::map_file()
+{
+    ASSERT(!n_users);
+    unmap_file();
+    if (fd == -1 || !file_len)
+        return;
+
+    void *base = mmap(nullptr, file_len, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        dprintf("package: mmap failed: %s\n", strerror(errno));
+        return;
+    }
+    map_base = (const char*)base;
+    map_len = file_len;
+}
+
+void package::unmap_file()
+{
+    if (map_base)
+        munmap((void*)map_base, map_len);
+    map_base = nullptr;
+    map_len = 0;
+}
+#endif
+
+// Where the given bytes of the file are in memory, or nullptr if they
+// aren't mapped.
+const char *package::mapped(plen_t at, plen_t len) const
+{
+#ifdef USE_MMAP
+    if (map_base && at <= map_len && len <= map_len - at)
+        return map_base + at;
+#endif
+    return nullptr;
+}
+
 void package::seek(plen_t to)
 {
     ASSERT(!aborted);
@@ -275,11 +452,13 @@ void package::seek(plen_t to)
 
 chunk_writer* package::writer(const string &name)
 {
+    sync();
     return new chunk_writer(this, name);
 }
 
 chunk_reader* package::reader(const string &name)
 {
+    sync();
     if (plen_t *ch = map_find(directory, name))
         return new chunk_reader(this, *ch);
     return 0;
@@ -378,13 +557,16 @@ void package::free_chunk(const string &name)
 
 void package::delete_chunk(const string &name)
 {
+    sync();
     free_chunk(name);
     directory.erase(name);
 }
 
 plen_t package::write_directory()
 {
-    delete_chunk("");
+    // Not delete_chunk(): this may run on the save thread.
+    free_chunk("");
+    directory.erase("");
 
     stringstream dir;
     for (const auto &entry : directory)
@@ -558,11 +740,13 @@ void package::read_directory(plen_t start, uint8_t version)
 
 bool package::has_chunk(const string &name)
 {
+    sync();
     return !name.empty() && directory.count(name);
 }
 
 vector<string> package::list_chunks()
 {
+    sync();
     vector<string> list;
     list.reserve(directory.size());
     for (const auto &entry : directory)
@@ -613,12 +797,17 @@ void package::abort()
     // Disable any further operations, allow a shutdown. All errors past
     // this point are ignored (assuming we already failed). All writes since
     // the last commit() are lost.
+    wait_for_job(false);
+    queued_chunks.clear();
     aborted = true;
 }
 
 void package::unlink()
 {
     abort();
+#ifdef USE_MMAP
+    unmap_file();
+#endif
     close(fd);
     fd = -1;
     ::unlink_u(filename.c_str());
@@ -627,6 +816,7 @@ void package::unlink()
 // the amount of free space not at the end of file
 plen_t package::get_slack()
 {
+    sync();
     load_traces();
 
     plen_t slack = 0;
@@ -637,6 +827,7 @@ plen_t package::get_slack()
 
 plen_t package::get_chunk_fragmentation(const string &name)
 {
+    sync();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t frags = 0;
@@ -653,6 +844,7 @@ plen_t package::get_chunk_fragmentation(const string &name)
 
 plen_t package::get_chunk_compressed_length(const string &name)
 {
+    sync();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t len = 0;
@@ -799,6 +991,12 @@ void chunk_writer::write(const void *data, plen_t len)
 void chunk_reader::init(plen_t start)
 {
     ASSERT(!pkg->aborted);
+#ifdef USE_MMAP
+    // Blocks written since the file was last mapped aren't in the mapping;
+    // catch up while nobody is holding on to it.
+    if (!pkg->n_users && pkg->map_len < pkg->file_len)
+        pkg->map_file();
+#endif
     pkg->n_users++;
     pkg->reader_count[start]++;
     first_block = next_block = start;
@@ -813,6 +1011,7 @@ void chunk_reader::init(plen_t start)
     zs.opaque    = Z_NULL;
     zs.next_in   = Z_NULL;
     zs.avail_in  = 0;
+    z_buffer     = nullptr;
     if (inflateInit(&zs))
         fail("save file decompression failed during init: %s", zs.msg);
     eof = false;
@@ -842,6 +1041,7 @@ chunk_reader::~chunk_reader()
     dprintf("chunk_reader: closing\n");
 
 #ifdef USE_ZLIB
+    free(z_buffer);
     if (inflateEnd(&zs) != Z_OK)
         fail("save file decompression failed during clean-up: %s", zs.msg);
 #endif
@@ -852,42 +1052,57 @@ chunk_reader::~chunk_reader()
     pkg->n_users--;
 }
 
+// Move on to the next block of the chunk. Returns false at the end of it.
+bool chunk_reader::next_block_header()
+{
+    if (!next_block)
+        return false;
+
+    block_header bl;
+    if (const char *m = pkg->mapped(next_block, sizeof(block_header)))
+        memcpy(&bl, m, sizeof(block_header));
+    else
+    {
+        pkg->seek(next_block);
+        ssize_t res = ::read(pkg->fd, &bl, sizeof(block_header));
+        if (res < 0)
+            sysfail("error reading the save file");
+        if (res != sizeof(block_header))
+            corrupted("save file corrupted -- block past eof");
+    }
+
+    off = next_block + sizeof(block_header);
+    block_left = htole(bl.len);
+    next_block = htole(bl.next);
+    // This reeks of on-disk corruption (zeroed data).
+    if (!block_left)
+        corrupted("save file corrupted -- empty block");
+    return true;
+}
+
 plen_t chunk_reader::raw_read(void *data, plen_t len)
 {
     void *buf = data;
     while (len)
     {
-        if (!block_left)
-        {
-            if (!next_block)
-                return (char*)buf - (char*)data;
+        if (!block_left && !next_block_header())
+            return (char*)buf - (char*)data;
+
+        plen_t s = len;
+        if (s > block_left)
+            s = block_left;
 
-            block_header bl;
-            pkg->seek(next_block);
-            ssize_t res = ::read(pkg->fd, &bl, sizeof(block_header));
+        if (const char *m = pkg->mapped(off, s))
+            memcpy(buf, m, s);
+        else
+        {
+            pkg->seek(off);
+            ssize_t res = ::read(pkg->fd, buf, s);
             if (res < 0)
                 sysfail("error reading the save file");
-            if (res != sizeof(block_header))
+            if ((plen_t)res != s)
                 corrupted("save file corrupted -- block past eof");
-
-            off = next_block + sizeof(block_header);
-            block_left = htole(bl.len);
-            next_block = htole(bl.next);
-            // This reeks of on-disk corruption (zeroed data).
-            if (!block_left)
-                corrupted("save file corrupted -- empty block");
         }
-        else
-            pkg->seek(off);
-
-        plen_t s = len;
-        if (s > block_left)
-            s = block_left;
-        ssize_t res = ::read(pkg->fd, buf, s);
-        if (res < 0)
-            sysfail("error reading the save file");
-        if ((plen_t)res != s)
-            corrupted("save file corrupted -- block past eof");
 
         buf = (char*)buf + s;
         off += s;
@@ -898,6 +1113,25 @@ plen_t chunk_reader::raw_read(void *data, plen_t len)
     return (char*)buf - (char*)data;
 }
 
+// Hand out the rest of the current block (or the next one) in place in the
+// mapped file. Returns 0 at the end of the chunk, or if the block isn't
+// mapped, in which case raw_read() has to copy it.
+plen_t chunk_reader::mapped_read(const void *&data)
+{
+    if (!block_left && !next_block_header())
+        return 0;
+
+    const char *m = pkg->mapped(off, block_left);
+    if (!m)
+        return 0;
+
+    const plen_t s = block_left;
+    data = m;
+    off += s;
+    block_left = 0;
+    return s;
+}
+
 plen_t chunk_reader::read(void *data, plen_t len)
 {
     ASSERT(data);
@@ -916,8 +1150,20 @@ plen_t chunk_reader::read(void *data, plen_t len)
     {
         if (!zs.avail_in)
         {
-            zs.next_in  = z_buffer;
-            zs.avail_in = raw_read(z_buffer, sizeof(z_buffer));
+            const void *m;
+            if (plen_t s = mapped_read(m))
+            {
+                // zlib never writes to its input.
+                zs.next_in  = (Bytef*)m;
+                zs.avail_in = s;
+            }
+            else
+            {
+                if (!z_buffer)
+                    z_buffer = (Bytef*)malloc(ZB_SIZE);
+                zs.next_in  = z_buffer;
+                zs.avail_in = raw_read(z_buffer, ZB_SIZE);
+            }
             if (!zs.avail_in)
                 corrupted("save file corrupted -- block truncated");
         }
@@ -936,16 +1182,31 @@ plen_t chunk_reader::read(void *data, plen_t len)
 #endif
 }
 
-void chunk_reader::read_all(vector<char> &data)
+// Inflate the rest of the chunk onto the end of data, in ever larger
+// pieces so that big chunks don't take many passes.
+template<typename T>
+static void _read_all(chunk_reader &cr, vector<T> &data)
 {
-#define SPACE 1024
-    plen_t s, at;
-    do
+    plen_t at = data.size();
+    plen_t want = max<plen_t>(1024, at);
+    while (true)
     {
-        at = data.size();
-        data.resize(at + SPACE);
-        s = read(&data[at], SPACE);
-    } while (s == SPACE);
-    data.resize(at + s);
-#undef SPACE
+        data.resize(at + want);
+        const plen_t s = cr.read(&data[at], want);
+        at += s;
+        if (s < want)
+            break;
+        want *= 2;
+    }
+    data.resize(at);
+}
+
+void chunk_reader::read_all(vector<char> &data)
+{
+    _read_all(*this, data);
+}
+
+void chunk_reader::read_all(vector<unsigned char> &data)
+{
+    _read_all(*this, data);
 }
@@ -14,6 +14,17 @@
 #define DO_FSYNC
 #endif
 
+// Read chunks straight out of a memory mapping of the save.
+#ifndef TARGET_OS_WINDOWS
+#define USE_MMAP
+#endif
+
+// Compress and write chunks on a background thread. Commits stay on the
+// main thread.
+#ifndef __ANDROID__
+#define ASYNC_SAVE
+#endif
+
 #define MAX_CHUNK_NAME_LENGTH 255
 
 typedef uint32_t plen_t;
@@ -52,14 +63,18 @@ private:
 #ifdef USE_ZLIB
     bool eof;
     z_stream zs;
-    Bytef z_buffer[32768];
+    // Only needed when the save can't be mapped.
+    Bytef *z_buffer;
 #endif
+    bool next_block_header();
     plen_t raw_read(void *data, plen_t len);
+    plen_t mapped_read(const void *&data);
 public:
     chunk_reader(package *parent, const string &_name);
     ~chunk_reader();
     plen_t read(void *data, plen_t len);
     void read_all(vector<char> &data);
+    void read_all(vector<unsigned char> &data);
     friend class package;
 };
 
@@ -78,6 +93,13 @@ public:
     void abort();
     void unlink();
 
+    // Chunks that are already marshalled can be queued with write_async(),
+    // then compressed and written in the background by flush_async(). Any
+    // other use of the package, commit() included, waits for that first.
+    void write_async(const string &name, vector<unsigned char> &data);
+    void flush_async();
+    void sync();
+
     // statistics
     plen_t get_slack();
     plen_t get_size() const { return file_len; };
@@ -100,6 +122,24 @@ private:
     map<plen_t, pair<plen_t, plen_t> > block_map;
     set<plen_t> new_chunks;
     map<plen_t, uint32_t> reader_count;
+#ifdef USE_MMAP
+    // A read-only mapping of the first map_len bytes of the file. Readers
+    // may hold pointers into it, so it's only ever replaced while there
+    // are none.
+    const char *map_base;
+    plen_t map_len;
+    void map_file();
+    void unmap_file();
+#endif
+    vector<pair<string, vector<unsigned char> > > queued_chunks;
+#ifdef ASYNC_SAVE
+    struct save_job;
+    save_job *job;
+    static void *run_job(void *arg);
+#endif
+    void wait_for_job(bool report_errors);
+    void write_chunks(vector<pair<string, vector<unsigned char> > > &chunks);
+    const char *mapped(plen_t at, plen_t len) const;
     plen_t extend_block(plen_t at, plen_t size, plen_t by);
     plen_t alloc_block(plen_t &size);
     void finish_chunk(const string &name, plen_t at);
@@ -191,6 +191,156 @@ pattern_match text_pattern::match_location(const char *s, int length) const
         return pattern_match::failed(string(s));
 }
 
+#ifdef REGEX_PCRE
+// Can this pattern be one alternative of a larger expression without
+// changing what it, or anything around it, matches? Numbered and named
+// references would point at the wrong groups, \Q could swallow the rest of
+// the expression, and verbs and most (?...) constructs are only safe on
+// their own; this errs on the side of saying no.
+static bool _combinable_pattern(const string &pat)
+{
+    for (size_t i = 0; i + 1 < pat.length(); ++i)
+    {
+        const char next = pat[i + 1];
+        if (pat[i] == '\\')
+        {
+            if (next >= '0' && next <= '9' || next == 'g' || next == 'k'
+                || next == 'Q' || next == 'E')
+            {
+                return false;
+            }
+            ++i;
+        }
+        else if (pat[i] == '(' && next == '*')
+            return false;
+        else if (pat[i] == '(' && next == '?')
+        {
+            const string rest = pat.substr(i + 2, 3);
+            if (!starts_with(rest, ":") && !starts_with(rest, "=")
+                && !starts_with(rest, "!") && !starts_with(rest, "<=")
+                && !starts_with(rest, "<!") && !starts_with(rest, "i)")
+                && !starts_with(rest, "i:") && !starts_with(rest, "-i)")
+                && !starts_with(rest, "-i:"))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+pattern_set::~pattern_set()
+{
+    _free_compiled_pattern(combined);
+}
+
+void pattern_set::clear()
+{
+    _free_compiled_pattern(combined);
+    combined = nullptr;
+    group_count = 0;
+    patterns.clear();
+    groups.clear();
+}
+
+void pattern_set::set_patterns(const vector<text_pattern> &pats)
+{
+    if (pats == patterns)
+        return;
+
+    clear();
+    patterns = pats;
+    compile();
+}
+
+// Each pattern which can be combined becomes a capturing group of one big
+// alternation; which group took part in a match says which pattern matched.
+void pattern_set::compile()
+{
+    groups.assign(patterns.size(), -1);
+#ifdef REGEX_PCRE
+    string expr;
+    int group = 1;
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        const text_pattern &pat = patterns[i];
+        // Invalid patterns never match, so leave them to text_pattern.
+        if (!pat.valid() || !_combinable_pattern(pat.tostring()))
+            continue;
+
+        void *cp = _compile_pattern(pat.tostring().c_str(), pat.ignores_case());
+        if (!cp)
+            continue;
+        int captures = 0;
+        pcre_fullinfo(static_cast<pcre *>(cp), nullptr, PCRE_INFO_CAPTURECOUNT,
+                      &captures);
+        _free_compiled_pattern(cp);
+
+        if (!expr.empty())
+            expr += "|";
+        expr += pat.ignores_case() ? "((?i)" : "(";
+        expr += pat.tostring();
+        expr += ")";
+        groups[i] = group;
+        group += 1 + captures;
+    }
+
+    if (expr.empty())
+        return;
+
+    combined = _compile_pattern(expr.c_str(), false);
+    if (!combined)
+    {
+        groups.assign(patterns.size(), -1);
+        return;
+    }
+    group_count = group;
+    ovector.resize(group_count * 3);
+#endif
+}
+
+bool pattern_set::matches(const string &s) const
+{
+#ifdef REGEX_PCRE
+    if (combined && _pattern_match(combined, s.c_str(), s.length()))
+        return true;
+#endif
+    for (size_t i = 0; i < patterns.size(); ++i)
+        if (groups[i] < 0 && patterns[i].matches(s))
+            return true;
+    return false;
+}
+
+int pattern_set::first_match(const string &s) const
+{
+    int found = -1;
+#ifdef REGEX_PCRE
+    if (combined)
+    {
+        const int rc = pcre_exec(static_cast<pcre *>(combined), nullptr,
+                                 s.c_str(), s.length(), 0, 0,
+                                 ovector.data(), ovector.size());
+        for (size_t i = 0; rc > 0 && i < patterns.size(); ++i)
+        {
+            if (groups[i] > 0 && groups[i] < rc && ovector[2 * groups[i]] >= 0)
+            {
+                found = i;
+                break;
+            }
+        }
+    }
+#endif
+    // The combined expression only reports the first alternative to match
+    // at the leftmost position, so an earlier pattern might still match
+    // further on; and patterns tried on their own have not been tried yet.
+    const int limit = found == -1 ? patterns.size() : found;
+    for (int i = 0; i < limit; ++i)
+        if ((found != -1 || groups[i] < 0) && patterns[i].matches(s))
+            return i;
+    return found;
+}
+
 const plaintext_pattern &plaintext_pattern::operator= (const string &spattern)
 {
     if (pattern == spattern)
@@ -117,6 +117,8 @@ public:
         return pattern;
     }
 
+    bool ignores_case() const { return ignore_case; }
+
 private:
     string pattern;
     mutable void *compiled_pattern;
@@ -124,6 +126,44 @@ private:
     bool ignore_case;
 };
 
+// A list of text_patterns compiled together into one expression, so that
+// checking a string against all of them takes a single scan rather than one
+// per pattern. Patterns using features which would change meaning inside a
+// larger expression (backreferences, subroutine calls, \Q...\E and the like)
+// are still tried on their own. Without PCRE, every pattern is tried on its
+// own.
+class pattern_set
+{
+public:
+    pattern_set() : combined(nullptr), group_count(0) { }
+    ~pattern_set();
+    pattern_set(const pattern_set &) = delete;
+    pattern_set &operator = (const pattern_set &) = delete;
+
+    // Use these patterns; does nothing if they are the ones already in use.
+    void set_patterns(const vector<text_pattern> &pats);
+    void clear();
+
+    bool empty() const { return patterns.empty(); }
+
+    // Does any of the patterns match s?
+    bool matches(const string &s) const;
+
+    // The index of the first pattern (in the order given) to match s, or -1.
+    int first_match(const string &s) const;
+
+private:
+    void compile();
+
+    vector<text_pattern> patterns;
+    // For each pattern, its capturing group in the combined expression, or
+    // -1 if it must be tried on its own.
+    vector<int> groups;
+    void *combined;
+    int group_count;
+    mutable vector<int> ovector;
+};
+
 class plaintext_pattern : public base_pattern
 {
 public:
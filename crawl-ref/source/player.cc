@@ -2368,6 +2368,7 @@ void forget_map(bool rot)
 #endif
     }
 
+    invalidate_travel_regions();
     ash_detect_portals(is_map_persistent());
 #ifdef USE_TILE
     tiles.update_minimap_bounds();
@@ -8108,6 +8109,7 @@ void player_open_door(coord_def doorpos)
         if (env.map_knowledge(dc).seen())
         {
             env.map_knowledge(dc).set_feature(DNGN_OPEN_DOOR);
+            update_travel_region_cell(dc);
 #ifdef USE_TILE
             env.tile_bk_bg(dc) = TILE_DNGN_OPEN_DOOR;
 #endif
@@ -8268,6 +8270,7 @@ void player_close_door(coord_def doorpos)
         if (env.map_knowledge(dc).seen())
         {
             env.map_knowledge(dc).set_feature(DNGN_CLOSED_DOOR);
+            update_travel_region_cell(dc);
 #ifdef USE_TILE
             env.tile_bk_bg(dc) = TILE_DNGN_CLOSED_DOOR;
 #endif
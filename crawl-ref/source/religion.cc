@@ -2601,6 +2601,7 @@ void excommunication(bool voluntary, god_type new_god)
     you.num_current_gifts[old_god] = 0;
 
     you.religion = GOD_NO_GOD;
+    invalidate_autopickup_cache();
 
     you.redraw_title = true;
 
@@ -3534,6 +3535,7 @@ void join_religion(god_type which_god)
 
     // Welcome to the fold!
     you.religion = static_cast<god_type>(which_god);
+    invalidate_autopickup_cache();
 
     mark_milestone("god.worship", "became a worshipper of "
                    + god_name(you.religion) + ".");
@@ -36,7 +36,10 @@
 #include "terrain.h"
 #include "view.h"
 
-static noise_grid _noise_grid;
+// Noises are registered on one grid while the other propagates the previous
+// batch, so that noises made in reaction to a noise are heard next time.
+static noise_grid _noise_grids[2];
+static noise_grid *_noise_grid = &_noise_grids[0];
 static void _actor_apply_noise(actor *act,
                                const coord_def &apparent_source,
                                int noise_intensity_millis,
@@ -763,16 +766,17 @@ void yell(const actor* mon)
 
 void apply_noises()
 {
-    // [ds] This copying isn't awesome, but we cannot otherwise handle
-    // the case where one set of noises wakes up monsters who then let
-    // out yips of their own, modifying _noise_grid while it is in the
-    // middle of propagate_noise().
-    if (_noise_grid.dirty())
+    // [ds] We cannot otherwise handle the case where one set of noises
+    // wakes up monsters who then let out yips of their own, modifying
+    // _noise_grid while it is in the middle of propagate_noise(). Rather
+    // than copying the grid, switch new noises to the other (clean) one.
+    if (_noise_grid->dirty())
     {
-        noise_grid copy = _noise_grid;
-        // Reset the main grid.
-        _noise_grid.reset();
-        copy.propagate_noise();
+        noise_grid *propagating = _noise_grid;
+        _noise_grid = propagating == &_noise_grids[0] ? &_noise_grids[1]
+                                                      : &_noise_grids[0];
+        propagating->propagate_noise();
+        propagating->reset();
     }
 }
 
@@ -812,7 +816,7 @@ bool noisy(int original_loudness, const coord_def& where,
     // Add +1 to scaled_loudness so that all squares adjacent to a
     // sound of loudness 1 will hear the sound.
     const string noise_msg(msg? msg : "");
-    _noise_grid.register_noise(
+    _noise_grid->register_noise(
         noise_t(where, noise_msg, (scaled_loudness + 1) * 1000, who, flags));
 
     // Some users of noisy() want an immediate answer to whether the
@@ -923,10 +927,8 @@ void blood_smell(int strength, const coord_def& where)
 
 // Currently noise attenuation depends solely on the feature in question.
 // Permarock walls are assumed to completely kill noise.
-static int _noise_attenuation_millis(const coord_def &pos)
+static int _feat_noise_attenuation_millis(dungeon_feature_type feat)
 {
-    const dungeon_feature_type feat = grd(pos);
-
     if (feat_is_permarock(feat))
         return NOISE_ATTENUATION_COMPLETE;
 
@@ -938,6 +940,25 @@ static int _noise_attenuation_millis(const coord_def &pos)
                                           1);
 }
 
+// Since attenuation depends only on the feature, it is worked out once for
+// each feature rather than for every cell a noise passes through; there is
+// nothing to invalidate when the terrain changes.
+static int _noise_attenuation_millis(const coord_def &pos)
+{
+    static int attenuation[NUM_FEATURES];
+    static bool attenuation_known = false;
+    if (!attenuation_known)
+    {
+        for (int feat = 0; feat < NUM_FEATURES; ++feat)
+        {
+            attenuation[feat] = _feat_noise_attenuation_millis(
+                                    static_cast<dungeon_feature_type>(feat));
+        }
+        attenuation_known = true;
+    }
+    return attenuation[grd(pos)];
+}
+
 noise_cell::noise_cell()
     : neighbour_delta(0, 0), noise_id(-1), noise_intensity_millis(0),
       noise_travel_distance(0)
@@ -989,11 +1010,32 @@ noise_grid::noise_grid()
 
 void noise_grid::reset()
 {
-    cells.init(noise_cell());
+    for (const coord_def &p : touched_cells)
+        cells(p) = noise_cell();
+    touched_cells.clear();
     noises.clear();
     affected_actor_count = 0;
 }
 
+// Apply a noise to a cell, remembering the cell so that reset() can clear it.
+bool noise_grid::apply_noise_to_cell(const coord_def &pos,
+                                     int noise_intensity_millis,
+                                     int noise_id,
+                                     int travel_distance,
+                                     const coord_def &neighbour_delta)
+{
+    noise_cell &cell(cells(pos));
+    const bool untouched = cell.noise_id == -1;
+    if (!cell.apply_noise(noise_intensity_millis, noise_id, travel_distance,
+                          neighbour_delta))
+    {
+        return false;
+    }
+    if (untouched)
+        touched_cells.push_back(pos);
+    return true;
+}
+
 void noise_grid::register_noise(const noise_t &noise)
 {
     noise_cell &target_cell(cells(noise.noise_source));
@@ -1002,10 +1044,11 @@ void noise_grid::register_noise(const noise_t &noise)
         const int noise_index = noises.size();
         noises.push_back(noise);
         noises[noise_index].noise_id = noise_index;
-        cells(noise.noise_source).apply_noise(noise.noise_intensity_millis,
-                                              noise_index,
-                                              0,
-                                              coord_def(0, 0));
+        apply_noise_to_cell(noise.noise_source,
+                            noise.noise_intensity_millis,
+                            noise_index,
+                            0,
+                            coord_def(0, 0));
     }
 }
 
@@ -1018,9 +1061,12 @@ void noise_grid::propagate_noise()
     dprf(DIAG_NOISE, "noise_grid: %u noises to apply",
          (unsigned int)noises.size());
 #endif
-    vector<coord_def> noise_perimeter[2];
     int circ_index = 0;
+    noise_perimeter[0].clear();
+    noise_perimeter[1].clear();
 
+    // All the noises registered since the last propagation spread out
+    // together, one ring per unit of travel distance.
     for (const noise_t &noise : noises)
         noise_perimeter[circ_index].push_back(noise.noise_source);
 
@@ -1111,10 +1157,11 @@ bool noise_grid::propagate_noise_to_neighbour(int base_attenuation,
     if (noise_is_audible(attenuated_noise_intensity))
     {
         const int neighbour_old_distance = neighbour.noise_travel_distance;
-        if (neighbour.apply_noise(attenuated_noise_intensity,
-                                  cell.noise_id,
-                                  travel_distance,
-                                  next_pos - current_pos))
+        if (apply_noise_to_cell(next_pos,
+                                attenuated_noise_intensity,
+                                cell.noise_id,
+                                travel_distance,
+                                next_pos - current_pos))
             // Return true only if we hadn't already registered this
             // cell as a neighbour (presumably with a lower volume).
             return neighbour_old_distance != travel_distance;
@@ -549,6 +549,7 @@ void show_init(layers_type layers)
     for (radius_iterator ri(you.pos(), you.xray_vision ? LOS_NONE : LOS_DEFAULT); ri; ++ri)
     {
         show_update_at(*ri, layers);
+        update_travel_region_cell(*ri);
         update_locs.push_back(*ri);
     }
 
@@ -34,6 +34,7 @@
 #include "terrain.h"
 #include "tiledef-dngn.h"
 #include "traps.h"
+#include "travel.h"
 #include "view.h"
 #include "viewchar.h"
 
@@ -914,6 +915,7 @@ static bool _do_imprison(int pow, const coord_def& where, bool zin)
                 {
                     env.map_knowledge(*ai).set_feature(DNGN_METAL_WALL);
                     env.map_knowledge(*ai).clear_item();
+                    update_travel_region_cell(*ai);
 #ifdef USE_TILE
                     env.tile_bk_bg(*ai) = TILE_DNGN_SILVER_WALL;
                     env.tile_bk_fg(*ai) = 0;
@@ -23,6 +23,7 @@
 #include "env.h"
 #include "feature.h"
 #include "godpassive.h"
+#include "hash.h"
 #include "hints.h"
 #include "invent.h"
 #include "itemprop.h"
@@ -245,11 +246,14 @@ bool Stash::unmark_trapping_nets()
     for (auto &item : items)
         if (item_is_stationary_net(item))
             item.net_placed = false, changed = true;
+    if (changed)
+        invalidate_search_cache();
     return changed;
 }
 
 void Stash::update()
 {
+    invalidate_search_cache();
     feat = grd(pos);
     trap = NUM_TRAPS;
 
@@ -438,6 +442,91 @@ string Stash::feature_description() const
     return feat_desc;
 }
 
+// Item names and search annotations depend on what the player knows about
+// item types, and on a few things about the player; cached search text is
+// only good while none of those change. Starts at 1, since a stash with an
+// epoch of 0 has no cache.
+static unsigned int _stash_search_epoch = 1;
+
+static uint32_t _search_state_hash()
+{
+    fnv_hash32 hash;
+    for (int i = 0; i < NUM_OBJECT_CLASSES; ++i)
+        for (int j = 0; j < MAX_SUBTYPES; ++j)
+            hash.mix(you.type_ids[i][j]);
+    hash.mix(you.species);
+    hash.mix(you.form);
+    hash.mix(you.religion);
+    hash.mix(Options.show_god_gift);
+    return hash.value();
+}
+
+static void _refresh_search_epoch()
+{
+    static uint32_t last_hash = 0;
+    const uint32_t hash = _search_state_hash();
+    if (hash != last_hash)
+    {
+        last_hash = hash;
+        ++_stash_search_epoch;
+    }
+}
+
+// Could anything with these (sorted) trigrams match the search? Only
+// plain-text searches can be ruled out: their lowercased text must appear
+// in the lowercased string searched, and so must each of its trigrams.
+static bool _trigrams_may_match(const base_pattern &search,
+                                const vector<uint32_t> &trigrams)
+{
+    const plaintext_pattern *plain =
+        dynamic_cast<const plaintext_pattern *>(&search);
+    if (!plain)
+        return true;
+
+    static string last_search;
+    static vector<uint32_t> wanted;
+    if (plain->tostring() != last_search)
+    {
+        last_search = plain->tostring();
+        wanted.clear();
+        add_trigrams(lowercase_string(last_search), wanted);
+    }
+
+    for (uint32_t trigram : wanted)
+        if (!binary_search(trigrams.begin(), trigrams.end(), trigram))
+            return false;
+    return true;
+}
+
+void Stash::build_search_cache(const string &prefix) const
+{
+    search_texts.clear();
+    search_trigrams.clear();
+    for (const item_def &item : items)
+    {
+        item_search_text text;
+        text.name = stash_item_name(item);
+        text.text = stash_annotate_item(STASH_LUA_SEARCH_ANNOTATE, &item)
+                    + " " + text.name;
+        text.dumpable = is_dumpable_artefact(item);
+        if (text.dumpable)
+            text.desc = chardump_desc(item);
+
+        add_trigrams(lowercase_string(prefix + " " + text.text),
+                      search_trigrams);
+        add_trigrams(lowercase_string(text.desc), search_trigrams);
+        search_texts.push_back(text);
+    }
+    add_trigrams(lowercase_string(feature_description()), search_trigrams);
+
+    sort(search_trigrams.begin(), search_trigrams.end());
+    search_trigrams.erase(unique(search_trigrams.begin(),
+                                 search_trigrams.end()),
+                          search_trigrams.end());
+    search_prefix = prefix;
+    search_epoch = _stash_search_epoch;
+}
+
 vector<stash_search_result> Stash::matches_search(
     const string &prefix, const base_pattern &search) const
 {
@@ -445,16 +534,21 @@ vector<stash_search_result> Stash::matches_search(
     if (empty())
         return results;
 
-    for (const item_def &item : items)
+    if (search_epoch != _stash_search_epoch || search_prefix != prefix)
+        build_search_cache(prefix);
+
+    if (!_trigrams_may_match(search, search_trigrams))
+        return results;
+
+    for (size_t i = 0; i < items.size(); ++i)
     {
-        const string s   = stash_item_name(item);
-        const string ann = stash_annotate_item(STASH_LUA_SEARCH_ANNOTATE, &item);
-        if (search.matches(prefix + " " + ann + " " + s)
-            || is_dumpable_artefact(item) && search.matches(chardump_desc(item)))
+        const item_search_text &text = search_texts[i];
+        if (search.matches(prefix + " " + text.text)
+            || text.dumpable && search.matches(text.desc))
         {
             stash_search_result res;
-            res.match = s;
-            res.item = item;
+            res.match = text.name;
+            res.item = items[i];
             results.push_back(res);
         }
     }
@@ -487,6 +581,7 @@ void Stash::_update_corpses(int rot_time)
 
         int new_rot = static_cast<int>(item.stash_freshness) - rot_time;
 
+        invalidate_search_cache();
         if (new_rot <= _min_rot(item))
         {
             items.erase(items.begin() + i);
@@ -500,13 +595,15 @@ void Stash::_update_identification()
 {
     for (int i = items.size() - 1; i >= 0; i--)
     {
-        god_id_item(items[i]);
+        if (god_id_item(items[i]))
+            invalidate_search_cache();
         maybe_identify_base_type(items[i]);
     }
 }
 
 void Stash::add_item(const item_def &item, bool add_to_front)
 {
+    invalidate_search_cache();
     if (_is_rottable(item))
         StashTrack.update_corpses();
 
@@ -618,6 +715,7 @@ void Stash::load(reader& inf)
 
     // Zap out item vector, in case it's in use (however unlikely)
     items.clear();
+    invalidate_search_cache();
     // Read in the items
     for (int i = 0; i < count; ++i)
     {
@@ -783,6 +881,21 @@ bool LevelStashes::needs_visit(const coord_def& c, bool autopickup) const
     return shop_needs_visit(c);
 }
 
+void LevelStashes::get_visit_squares(vector<coord_def> &squares,
+                                     bool autopickup) const
+{
+    for (const auto &entry : m_stashes)
+    {
+        const Stash &s = entry.second;
+        if (s.unverified() || autopickup && s.pickup_eligible())
+            squares.push_back(entry.first);
+    }
+
+    for (const ShopInfo &shop : m_shops)
+        if (!shop.is_visited())
+            squares.push_back(shop.shop.pos);
+}
+
 bool LevelStashes::needs_stop(const coord_def &c) const
 {
     const Stash *s = find_stash(c);
@@ -1407,6 +1520,8 @@ void StashTracker::get_matching_stashes(
         bool curr_lev)
     const
 {
+    _refresh_search_epoch();
+
     level_id curr = level_id::current();
     for (const auto &entry : levels)
     {
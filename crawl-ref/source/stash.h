@@ -66,6 +66,18 @@ private:
     void _update_identification();
     void add_item(const item_def &item, bool add_to_front = false);
 
+    // The text searches look at for one item.
+    struct item_search_text
+    {
+        string name;        // stash_item_name()
+        string text;        // search annotation and name
+        bool dumpable;      // also search the chardump description
+        string desc;
+    };
+
+    void build_search_cache(const string &prefix) const;
+    void invalidate_search_cache() { search_epoch = 0; }
+
 private:
     bool verified;      // Is this correct to the best of our knowledge?
     coord_def pos;
@@ -75,6 +87,13 @@ private:
 
     vector<item_def> items;
 
+    // Search text for each of items, and the sorted trigrams of all of it,
+    // valid while search_epoch matches the tracker's.
+    mutable vector<item_search_text> search_texts;
+    mutable vector<uint32_t> search_trigrams;
+    mutable string search_prefix;
+    mutable unsigned int search_epoch = 0;
+
     static bool are_items_same(const item_def &, const item_def &,
                                bool exact = false);
 
@@ -105,6 +124,7 @@ private:
     string shop_item_name(const item_def &it) const;
     string shop_item_desc(const item_def &it) const;
 
+    friend class LevelStashes;
     friend class ST_ItemIterator;
 };
 
@@ -184,6 +204,10 @@ public:
     bool  needs_visit(const coord_def& c, bool autopickup) const;
     bool  shop_needs_visit(const coord_def& c) const;
 
+    // Adds every square for which needs_visit() is true to squares.
+    void  get_visit_squares(vector<coord_def> &squares,
+                            bool autopickup) const;
+
     // Returns true if the items at c are not fully known to the stash-tracker
     // and the items are not all handled by autopickup.
     bool  needs_stop(const coord_def &c) const;
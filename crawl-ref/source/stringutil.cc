@@ -447,6 +447,16 @@ vector<string> split_string(const string &sep, string s, bool trim_segments,
     return segments;
 }
 
+void add_trigrams(const string &s, vector<uint32_t> &trigrams)
+{
+    for (size_t i = 2; i < s.length(); ++i)
+    {
+        trigrams.push_back((uint8_t) s[i - 2] << 16
+                           | (uint8_t) s[i - 1] << 8
+                           | (uint8_t) s[i]);
+    }
+}
+
 
 // Crude, but functional.
 string make_time_string(time_t abs_time, bool terse)
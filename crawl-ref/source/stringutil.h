@@ -234,6 +234,10 @@ static inline bool ends_with(const string &s, const string &suffix)
 vector<string> split_string(const string &sep, string s, bool trim = true,
                             bool accept_empties = false, int nsplits = -1);
 
+// Appends each run of three bytes in s to trigrams, packed into the low 24
+// bits, for indexing text by the substrings it contains.
+void add_trigrams(const string &s, vector<uint32_t> &trigrams);
+
 // time
 
 string make_time_string(time_t abs_time, bool terse = false);
@@ -97,7 +97,7 @@ extern set<pair<string, level_id> > auto_unique_annotations;
 extern abyss_state abyssal_state;
 
 reader::reader(const string &_read_filename, int minorVersion)
-    : _filename(_read_filename), _chunk(0), _pbuf(nullptr), _read_offset(0),
+    : _filename(_read_filename), _pdata(nullptr), _psize(0), _read_offset(0),
       _minorVersion(minorVersion), _safe_read(false)
 {
     _file       = fopen_u(_filename.c_str(), "rb");
@@ -105,17 +105,19 @@ reader::reader(const string &_read_filename, int minorVersion)
 }
 
 reader::reader(package *save, const string &chunkname, int minorVersion)
-    : _file(0), _chunk(0), opened_file(false), _pbuf(0), _read_offset(0),
-     _minorVersion(minorVersion), _safe_read(false)
+    : _file(0), opened_file(false), _pdata(nullptr), _psize(0),
+      _read_offset(0), _minorVersion(minorVersion), _safe_read(false)
 {
     ASSERT(save);
-    _chunk = new chunk_reader(save, chunkname);
+    // Unmarshalling a byte at a time is much cheaper from memory than
+    // through inflate().
+    chunk_reader(save, chunkname).read_all(_owned);
+    _pdata = _owned.data();
+    _psize = _owned.size();
 }
 
 reader::~reader()
 {
-    if (_chunk)
-        delete _chunk;
     close();
 }
 
@@ -141,7 +143,7 @@ void reader::advance(size_t offset)
 bool reader::valid() const
 {
     return (_file && !feof(_file)) ||
-           (_pbuf && _read_offset < _pbuf->size());
+           (_pdata && _read_offset < _psize);
 }
 
 static NORETURN void _short_read(bool safe_read)
@@ -163,18 +165,11 @@ unsigned char reader::readByte()
             _short_read(_safe_read);
         return b;
     }
-    else if (_chunk)
-    {
-        unsigned char buf;
-        if (_chunk->read(&buf, 1) != 1)
-            _short_read(_safe_read);
-        return buf;
-    }
     else
     {
-        if (_read_offset >= _pbuf->size())
+        if (_read_offset >= _psize)
             _short_read(_safe_read);
-        return (*_pbuf)[_read_offset++];
+        return _pdata[_read_offset++];
     }
 }
 
@@ -190,22 +185,31 @@ void reader::read(void *data, size_t size)
         else
             fseek(_file, (long)size, SEEK_CUR);
     }
-    else if (_chunk)
-    {
-        if (_chunk->read(data, size) != size)
-            _short_read(_safe_read);
-    }
     else
     {
-        if (_read_offset+size > _pbuf->size())
+        if (size > _psize - _read_offset)
             _short_read(_safe_read);
         if (data && size)
-            memcpy(data, &(*_pbuf)[_read_offset], size);
+            memcpy(data, _pdata + _read_offset, size);
 
         _read_offset += size;
     }
 }
 
+// For readers from memory, returns where the next size bytes are and skips
+// them; otherwise nullptr.
+const unsigned char *reader::read_span(size_t size)
+{
+    if (_file)
+        return nullptr;
+
+    if (size > _psize - _read_offset)
+        _short_read(_safe_read);
+    const unsigned char *span = _pdata + _read_offset;
+    _read_offset += size;
+    return span;
+}
+
 int reader::getMinorVersion() const
 {
     ASSERT(_minorVersion != TAG_MINOR_INVALID);
@@ -219,10 +223,7 @@ void reader::setMinorVersion(int minorVersion)
 
 void reader::fail_if_not_eof(const string &name)
 {
-    char dummy;
-    if (_chunk ? _chunk->read(&dummy, 1) :
-        _file ? (fgetc(_file) != EOF) :
-        _read_offset >= _pbuf->size())
+    if (_file ? (fgetc(_file) != EOF) : _read_offset < _psize)
     {
         fail("Incomplete read of \"%s\" - aborting.", name.c_str());
     }
@@ -328,7 +329,7 @@ static void unmarshallSpells(reader &, monster_spells &
 static void marshallMonsterInfo (writer &, const monster_info &);
 static void unmarshallMonsterInfo (reader &, monster_info &mi);
 static void marshallMapCell (writer &, const map_cell &);
-static void unmarshallMapCell (reader &, map_cell& cell);
+static void unmarshallMapCell (reader &, map_cell& cell, const coord_def &pos);
 
 template<typename T, typename T_iter, typename T_marshal>
 static void marshall_iterator(writer &th, T_iter beg, T_iter end,
@@ -1198,6 +1199,7 @@ static void _shunt_monsters_out_of_walls()
                     env.mgrid(m.pos()) = NON_MONSTER;
                     m.position = *di;
                     env.mgrid(*di) = i;
+                    monster_index_update(m);
                     break;
                 }
         }
@@ -1214,12 +1216,17 @@ void tag_read(reader &inf, tag_type tag_id)
     const int data_size = unmarshallInt(inf);
     ASSERT(data_size >= 0);
 
-    // Fetch data in one go
-    buf.resize(data_size);
-    inf.read(&buf[0], buf.size());
+    // Fetch data in one go, unless it's in memory already.
+    const unsigned char *data = inf.read_span(data_size);
+    if (!data)
+    {
+        buf.resize(data_size);
+        inf.read(&buf[0], buf.size());
+        data = buf.data();
+    }
 
     // Ok, we have data now.
-    reader th(buf, inf.getMinorVersion());
+    reader th(data, data_size, inf.getMinorVersion());
     switch (tag_id)
     {
     case TAG_YOU:
@@ -4622,7 +4629,7 @@ void marshallMapCell(writer &th, const map_cell &cell)
 
     if (flags & MAP_SERIALIZE_CLOUD)
     {
-        cloud_info* ci = cell.cloudinfo();
+        const cloud_info* ci = cell.cloudinfo();
         marshallUnsigned(th, ci->type);
         marshallUnsigned(th, ci->colour);
         marshallUnsigned(th, ci->duration);
@@ -4637,7 +4644,7 @@ void marshallMapCell(writer &th, const map_cell &cell)
         marshallMonsterInfo(th, *cell.monsterinfo());
 }
 
-void unmarshallMapCell(reader &th, map_cell& cell)
+void unmarshallMapCell(reader &th, map_cell& cell, const coord_def &pos)
 {
     unsigned flags = unmarshallUnsigned(th);
     unsigned cell_flags = 0;
@@ -4699,6 +4706,7 @@ void unmarshallMapCell(reader &th, map_cell& cell)
         if (th.getMinorVersion() >= TAG_MINOR_CLOUD_OWNER)
 #endif
         ci.killer = static_cast<killer_type>(unmarshallUByte(th));
+        ci.pos = pos;
         cell.set_cloud(ci);
     }
 
@@ -4713,6 +4721,7 @@ void unmarshallMapCell(reader &th, map_cell& cell)
     {
         monster_info mi;
         unmarshallMonsterInfo(th, mi);
+        mi.pos = pos;
         cell.set_monster(mi);
     }
 
@@ -5340,12 +5349,7 @@ static void tag_read_level(reader &th)
             grd[i][j] = feat;
             ASSERT(feat < NUM_FEATURES);
 
-            unmarshallMapCell(th, env.map_knowledge[i][j]);
-            // Fixup positions
-            if (env.map_knowledge[i][j].monsterinfo())
-                env.map_knowledge[i][j].monsterinfo()->pos = coord_def(i, j);
-            if (env.map_knowledge[i][j].cloudinfo())
-                env.map_knowledge[i][j].cloudinfo()->pos = coord_def(i, j);
+            unmarshallMapCell(th, env.map_knowledge[i][j], coord_def(i, j));
 
             env.map_knowledge[i][j].flags &= ~MAP_VISIBLE_FLAG;
             if (env.map_knowledge[i][j].seen())
@@ -5365,7 +5369,7 @@ static void tag_read_level(reader &th)
         MapKnowledge *f = new MapKnowledge();
         for (int x = 0; x < GXM; x++)
             for (int y = 0; y < GYM; y++)
-                unmarshallMapCell(th, (*f)[x][y]);
+                unmarshallMapCell(th, (*f)[x][y], coord_def(x, y));
         env.map_forgotten.reset(f);
     }
     else
@@ -5571,6 +5575,8 @@ static void tag_read_level_items(reader &th)
         if (item.pos.origin())
             item.clear();
 #endif
+
+    rebuild_free_item_slots();
 }
 
 void unmarshallMonster(reader &th, monster& m)
@@ -6025,6 +6031,7 @@ static void tag_read_level_monsters(reader &th)
     {
         monster& m = menv[i];
         unmarshallMonster(th, m);
+        monster_index_update(m);
 
         // place monster
         if (!m.alive())
@@ -98,18 +98,26 @@ class reader
 public:
     reader(const string &filename, int minorVersion = TAG_MINOR_INVALID);
     reader(FILE* input, int minorVersion = TAG_MINOR_INVALID)
-        : _file(input), _chunk(0), opened_file(false), _pbuf(0),
+        : _file(input), opened_file(false), _pdata(nullptr), _psize(0),
           _read_offset(0), _minorVersion(minorVersion), _safe_read(false) {}
     reader(const vector<unsigned char>& input,
            int minorVersion = TAG_MINOR_INVALID)
-        : _file(0), _chunk(0), opened_file(false), _pbuf(&input),
+        : _file(0), opened_file(false), _pdata(input.data()),
+          _psize(input.size()), _read_offset(0),
+          _minorVersion(minorVersion), _safe_read(false) {}
+    // Reads from memory the caller keeps alive, without copying it.
+    reader(const unsigned char *data, size_t size,
+           int minorVersion = TAG_MINOR_INVALID)
+        : _file(0), opened_file(false), _pdata(data), _psize(size),
           _read_offset(0), _minorVersion(minorVersion), _safe_read(false) {}
+    // Inflates the whole chunk up front and reads it from memory.
     reader(package *save, const string &chunkname,
            int minorVersion = TAG_MINOR_INVALID);
     ~reader();
 
     unsigned char readByte();
     void read(void *data, size_t size);
+    const unsigned char *read_span(size_t size);
     void advance(size_t size);
     int getMinorVersion() const;
     void setMinorVersion(int minorVersion);
@@ -124,9 +132,12 @@ public:
 private:
     string _filename;
     FILE* _file;
-    chunk_reader *_chunk;
     bool  opened_file;
-    const vector<unsigned char>* _pbuf;
+    // What we're reading from, if it's in memory; _owned holds a chunk
+    // read from a save.
+    const unsigned char *_pdata;
+    size_t _psize;
+    vector<unsigned char> _owned;
     unsigned int _read_offset;
     int _minorVersion;
     // always throw an exception rather than dying when reading past EOF
@@ -0,0 +1,32 @@
+-- Compare the speed of the old (ray at a time) and current (word at a
+-- time) losight kernels on the debug LOS maps used by los_maps.lua.
+-- Not run by default; select with: crawl -test big/los_bench
+
+local ITERATIONS = 2000
+
+local function bench_los_map(map)
+  dgn.reset_level()
+  dgn.tags(map, "no_rotate no_vmirror no_hmirror no_pool_fixup")
+  local function place_map()
+    return dgn.place_map(map, true, true)
+  end
+  dgn.with_map_anchors(30, 30, place_map)
+  you.moveto(30, 30)
+  return debug.los_benchmark(ITERATIONS)
+end
+
+local total_old, total_new, nmaps = 0, 0, 0
+local map = dgn.map_by_tag("debug_los")
+assert(map, "Could not find debug-los maps (tag 'debug_los')")
+while map do
+  local old_ms, new_ms = bench_los_map(map)
+  crawl.stderr(string.format("%-24s bitwise %8.2f ms  wordwise %8.2f ms",
+                             dgn.name(map), old_ms, new_ms))
+  total_old = total_old + old_ms
+  total_new = total_new + new_ms
+  nmaps = nmaps + 1
+  map = dgn.map_by_tag("debug_los")
+end
+
+crawl.stderr(string.format("%d maps x %d: bitwise %.2f ms, wordwise %.2f ms",
+                           nmaps, ITERATIONS, total_old, total_new))
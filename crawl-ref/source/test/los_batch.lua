@@ -0,0 +1,67 @@
+-- Check that the LOS fields cached for a whole region at once agree with
+-- those computed one centre at a time.
+
+local FAILMAP = 'losbatch.map'
+local R = 7
+local checks = 0
+
+local function snapshot(x1, y1, x2, y2)
+  local seen = { }
+  for x = x1, x2 do
+    for y = y1, y2 do
+      if dgn.in_bounds(x, y) then
+        for dx = -R, R do
+          for dy = -R, R do
+            local px, py = x + dx, y + dy
+            if dgn.in_bounds(px, py) then
+              local key = x .. "," .. y .. "," .. px .. "," .. py
+              seen[key] = los.cell_see_cell(x, y, px, py)
+            end
+          end
+        end
+      end
+    end
+  end
+  return seen
+end
+
+local function test_batch_los()
+  you.random_teleport()
+  local cx, cy = you.pos()
+  local x1, y1, x2, y2 = cx - R, cy - R, cx + R, cy + R
+
+  checks = checks + 1
+
+  debug.los_changed()
+  debug.los_cache_region(x1, y1, x2, y2)
+  local batched = snapshot(x1, y1, x2, y2)
+  debug.los_changed()
+  local single = snapshot(x1, y1, x2, y2)
+
+  for key, val in pairs(single) do
+    if batched[key] ~= val then
+      debug.dump_map(FAILMAP)
+      assert(false,
+             "batch LOS differs (iter #" .. checks .. "): " .. key
+               .. ". Map saved to " .. FAILMAP)
+    end
+  end
+end
+
+local function run_los_tests(depth, nlevels, tests_per_level)
+  local place = "D:" .. depth
+  crawl.message("Running batch LOS tests on " .. place)
+  debug.goto_place(place)
+
+  for lev_i = 1, nlevels do
+    debug.flush_map_memory()
+    debug.generate_level()
+    for t_i = 1, tests_per_level do
+      test_batch_los()
+    end
+  end
+end
+
+for depth = 1, 15, 4 do
+  run_los_tests(depth, 1, 2)
+end
@@ -0,0 +1,79 @@
+-- Check that local terrain changes keep the cached cell_see_cell results
+-- consistent with a full recomputation.
+
+local FAILMAP = 'losincr.map'
+local R = 7
+local checks = 0
+
+local function snapshot(cx, cy)
+  local seen = { }
+  for x = cx - 2 * R, cx + 2 * R do
+    for y = cy - 2 * R, cy + 2 * R do
+      if dgn.in_bounds(x, y) then
+        for dx = -R, R do
+          for dy = -R, R do
+            local px, py = x + dx, y + dy
+            if dgn.in_bounds(px, py) then
+              local key = x .. "," .. y .. "," .. px .. "," .. py
+              seen[key] = los.cell_see_cell(x, y, px, py)
+            end
+          end
+        end
+      end
+    end
+  end
+  return seen
+end
+
+local function test_incremental_los()
+  you.random_teleport()
+  local cx, cy = you.pos()
+
+  checks = checks + 1
+
+  -- Fill the cache around the player, then change some terrain.
+  snapshot(cx, cy)
+  for i = 1, 5 do
+    local x = cx + crawl.random_range(-R, R)
+    local y = cy + crawl.random_range(-R, R)
+    if dgn.in_bounds(x, y) and (x ~= cx or y ~= cy) then
+      local feat = dgn.feature_name(dgn.grid(x, y))
+      if feat == "floor" then
+        dgn.terrain_changed(x, y, "rock_wall", false, false)
+      elseif feat == "rock_wall" then
+        dgn.terrain_changed(x, y, "floor", false, false)
+      end
+    end
+  end
+
+  local cached = snapshot(cx, cy)
+  debug.los_changed()
+  local fresh = snapshot(cx, cy)
+
+  for key, val in pairs(fresh) do
+    if cached[key] ~= val then
+      debug.dump_map(FAILMAP)
+      assert(false,
+             "stale cell_see_cell after terrain change (iter #" .. checks
+               .. "): " .. key .. ". Map saved to " .. FAILMAP)
+    end
+  end
+end
+
+local function run_los_tests(depth, nlevels, tests_per_level)
+  local place = "D:" .. depth
+  crawl.message("Running incremental LOS tests on " .. place)
+  debug.goto_place(place)
+
+  for lev_i = 1, nlevels do
+    debug.flush_map_memory()
+    debug.generate_level()
+    for t_i = 1, tests_per_level do
+      test_incremental_los()
+    end
+  end
+end
+
+for depth = 1, 15, 2 do
+  run_los_tests(depth, 1, 2)
+end
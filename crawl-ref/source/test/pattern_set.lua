@@ -0,0 +1,60 @@
+-- Check that pattern_set, which folds patterns into one alternation,
+-- picks the same pattern as trying them one at a time in order.
+
+local function first_by_hand(patterns, text)
+  for i, p in ipairs(patterns) do
+    if crawl.regex(p):matches(text) then
+      return i
+    end
+  end
+  return nil
+end
+
+local function check(patterns, text, expected, icase)
+  local desc = "[" .. table.concat(patterns, "] [") .. "] on '" .. text .. "'"
+  local first, any = debug.first_matching_pattern(patterns, text, icase)
+  -- test.eq builds its message from both values, so no nils or booleans.
+  test.eq(tostring(first), tostring(expected), desc)
+  test.eq(tostring(any), tostring(expected ~= nil), desc .. " (any)")
+  if not icase then
+    test.eq(tostring(first), tostring(first_by_hand(patterns, text)),
+            desc .. " (by hand)")
+  end
+end
+
+-- Order: the first pattern in the list wins, even when a later one matches
+-- further left in the text.
+check({ "orc", "goblin" }, "the goblin hits the orc", 1)
+check({ "goblin", "orc" }, "the goblin hits the orc", 1)
+check({ "hits", "the" }, "the goblin hits the orc", 1)
+check({ "kobold", "orc" }, "the goblin hits the orc", 2)
+check({ "kobold", "rat" }, "the goblin hits the orc", nil)
+check({ }, "anything", nil)
+check({ "^You", "die" }, "You die...", 1)
+check({ "^die", "die\\.\\.\\.$" }, "You die...", 2)
+
+-- Patterns that can't go into the alternation (backreferences, \Q..\E,
+-- branch resets, named groups) are tried on their own, in their place in
+-- the order. Case-insensitive groups can go in.
+check({ "(o)\\1", "goblin" }, "the goblin hits the orc", 2)
+check({ "(o)\\1", "goblin" }, "a foolish goblin", 1)
+check({ "goblin", "(o)\\1" }, "a foolish goblin", 1)
+check({ "\\Qa.b\\E", "a" }, "axb", 2)
+check({ "\\Qa.b\\E", "a" }, "a.b", 1)
+check({ "x", "(?|(b)|(c))", "a" }, "ab", 2)
+check({ "(?<o>o)\\k<o>", "goblin" }, "a foolish goblin", 1)
+check({ "(?i)ORC", "goblin" }, "the goblin hits the orc", 1)
+check({ "rat", "(?i)ORC", "orc" }, "the goblin hits the orc", 2)
+
+-- Capture groups inside patterns shift the groups of those after them.
+check({ "(gob)(lin)", "(orc)" }, "the orc", 2)
+check({ "(a(b(c)))", "(x)(y)", "z" }, "z", 3)
+check({ "(a(b(c)))", "(x)(y)", "z" }, "xy and z", 2)
+check({ "(?:non)capturing", "(cap)(turing)", "ing" }, "capturing", 2)
+check({ "(?:non)capturing", "(cap)(turing)", "ing" }, "noncapturing", 1)
+check({ "(a)|(b)", "c" }, "cb", 1)
+check({ "(a)?c", "b" }, "bc", 1)
+
+-- Ignoring case applies to every pattern in the set.
+check({ "ORC", "goblin" }, "the Goblin hits the orc", 1, true)
+check({ "kobold", "GOBLIN" }, "the goblin hits the orc", 2, true)
@@ -0,0 +1,40 @@
+-- Check that a text database whose input file changes is rebuilt and read
+-- back, rather than the entries loaded before the rebuild staying in use.
+
+local dbfile = "test/textdb.txt"
+
+local function write_db(body)
+  assert(file.writefile(dbfile,
+                        "%%%%\nfirst\n\n" .. body .. "\n%%%%\nsecond\n\n"
+                        .. "An unchanging entry.\n%%%%\n"),
+         "can't write " .. dbfile)
+end
+
+local function keys_set(keys)
+  local set = { }
+  for _, k in ipairs(keys) do
+    set[k] = true
+  end
+  return set
+end
+
+write_db("A goblin with a club.")
+local body, found = debug.textdb_lookup("first", "goblin")
+test.eq(body, "A goblin with a club.\n", "initial body")
+assert(keys_set(found)["first"], "initial body search")
+
+-- The DB is rebuilt when the file's modification time changes, which is
+-- only kept to the second.
+local start = crawl.millis()
+while crawl.millis() - start < 1100 do
+end
+
+write_db("A kobold with a sling.")
+body, found = debug.textdb_lookup("first", "kobold")
+test.eq(body, "A kobold with a sling.\n", "body after rebuild")
+assert(keys_set(found)["first"], "body search after rebuild")
+
+body, found = debug.textdb_lookup("first", "goblin")
+assert(not keys_set(found)["first"], "old body still found")
+test.eq(debug.textdb_lookup("second", "unchanging"),
+        "An unchanging entry.\n", "unchanged entry")
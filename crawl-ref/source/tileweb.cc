@@ -67,6 +67,10 @@ TilesFramework tiles;
 
 TilesFramework::TilesFramework()
     : m_crt_mode(CRT_NORMAL),
+      m_msg_is_map_delta(false),
+      m_need_resync(false),
+      m_dropped_frames(0),
+      m_resyncs(0),
       m_controlled_from_web(false),
       m_last_ui_state(UI_INIT),
       m_view_loaded(false),
@@ -94,6 +98,10 @@ void TilesFramework::shutdown()
     if (m_sock_name.empty())
         return;
 
+    // Give the server a chance to see the last messages, but don't hang
+    // around for a reader that has stopped listening.
+    _drain_queues(5000);
+
     close(m_sock);
     remove(m_sock_name.c_str());
 }
@@ -168,68 +176,194 @@ void TilesFramework::write_message(const char *format, ...)
     m_msg_buf.append(buf);
 }
 
+// Queued output beyond which a receiver's pending map updates are dropped
+// in favour of a full map, and beyond which everything but server control
+// messages is dropped and the whole game state is resent.
+#define MAP_DROP_BYTES   (1024 * 1024)
+#define RESYNC_BYTES     (16 * 1024 * 1024)
+
 void TilesFramework::finish_message()
 {
-    if (m_msg_buf.size() == 0)
-        return;
-
-    if (m_sock_name.empty())
+    if (m_msg_buf.size() == 0 || m_sock_name.empty())
     {
         m_msg_buf.clear();
+        m_msg_is_map_delta = false;
         return;
     }
 
     m_msg_buf.append("\n");
-    const char* fragment_start = m_msg_buf.data();
-    const char* data_end = m_msg_buf.data() + m_msg_buf.size();
-    while (fragment_start < data_end)
+
+    QueuedMessage msg;
+    msg.data = make_shared<const string>(move(m_msg_buf));
+    msg.map_delta = m_msg_is_map_delta;
+    for (MessageDest &dest : m_dests)
+        _queue_message(dest, msg);
+    _flush_queues();
+
+    m_msg_buf.clear();
+    m_msg_is_map_delta = false;
+    m_need_flush = true;
+}
+
+void TilesFramework::_add_dest(const sockaddr_un &addr)
+{
+    MessageDest dest;
+    dest.addr = addr;
+    dest.queued_bytes = 0;
+    dest.front_sent = 0;
+    dest.max_depth = 0;
+    dest.dropped = 0;
+    m_dests.push_back(dest);
+}
+
+void TilesFramework::_queue_message(MessageDest &dest,
+                                    const QueuedMessage &msg)
+{
+    dest.queue.push_back(msg);
+    dest.queued_bytes += msg.data->size();
+    dest.max_depth = max(dest.max_depth, (unsigned int) dest.queue.size());
+
+    if (dest.queued_bytes <= MAP_DROP_BYTES)
+        return;
+
+    // This receiver is falling behind. Drop what can be regenerated,
+    // leaving alone the message that is partly sent and, since only the
+    // server sees them, control messages.
+    const bool resync = dest.queued_bytes > RESYNC_BYTES;
+    auto keep = [&](const QueuedMessage &m)
     {
-        int fragment_size = data_end - fragment_start;
-        if (fragment_size > m_max_msg_size)
-            fragment_size = m_max_msg_size;
+        if (&m == &dest.queue.front() && dest.front_sent)
+            return true;
+        if (resync)
+            return (*m.data)[0] == '*';
+        return !m.map_delta;
+    };
+
+    deque<QueuedMessage> kept;
+    size_t kept_bytes = 0;
+    unsigned int dropped = 0;
+    for (const QueuedMessage &m : dest.queue)
+    {
+        if (keep(m))
+        {
+            kept.push_back(m);
+            kept_bytes += m.data->size();
+        }
+        else
+            dropped++;
+    }
+    if (!dropped)
+        return;
 
-        for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
+    dest.queue.swap(kept);
+    dest.queued_bytes = kept_bytes;
+    dest.dropped += dropped;
+    m_dropped_frames += dropped;
+
+    // Every receiver gets the replacement; only this one needs it, but
+    // other receivers just see a redundant refresh.
+    m_need_full_map = true;
+    if (resync)
+    {
+        m_need_resync = true;
+        m_resyncs++;
+    }
+}
+
+// Send as much of the receiver's queue as its socket will take. Messages
+// are packed together into datagrams of up to m_max_msg_size bytes, and
+// larger messages are split. Returns false if the receiver has gone away.
+bool TilesFramework::_flush_dest(MessageDest &dest)
+{
+    while (!dest.queue.empty())
+    {
+        m_datagram.clear();
+        size_t size = 0;
+        for (const QueuedMessage &m : dest.queue)
         {
-            int retries = 30;
-            ssize_t sent = 0;
-            while (sent < fragment_size)
+            const size_t offset = size ? 0 : dest.front_sent;
+            const size_t len = m.data->size() - offset;
+            if (size + len > (size_t) m_max_msg_size)
             {
-                ssize_t retval = sendto(m_sock, fragment_start + sent,
-                    fragment_size - sent, 0, (sockaddr*) &m_dest_addrs[i],
-                    sizeof(sockaddr_un));
-                if (retval <= 0)
+                if (!size)
                 {
-                    const char *errmsg = retval == 0 ? "No bytes sent"
-                                                     : strerror(errno);
-                    if (--retries <= 0)
-                        die("Socket write error: %s", errmsg);
-
-                    if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
-                        || errno == EINTR || errno == EAGAIN)
-                    {
-                        // Wait for half a second at first (up to five), then
-                        // try again.
-                        usleep(retries <= 10 ? 5000 * 1000 : 500 * 1000);
-                    }
-                    else if (errno == ECONNREFUSED || errno == ENOENT)
-                    {
-                        // the other side is dead
-                        m_dest_addrs.erase(m_dest_addrs.begin() + i);
-                        i--;
-                        break;
-                    }
-                    else
-                        die("Socket write error: %s", errmsg);
+                    m_datagram.append(*m.data, offset, m_max_msg_size);
+                    size = m_max_msg_size;
                 }
-                else
-                    sent += retval;
+                break;
             }
+            m_datagram.append(*m.data, offset, len);
+            size += len;
         }
 
-        fragment_start += fragment_size;
+        ssize_t retval = sendto(m_sock, m_datagram.data(), size,
+                                MSG_DONTWAIT, (sockaddr*) &dest.addr,
+                                sizeof(sockaddr_un));
+        if (retval <= 0)
+        {
+            if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
+                || errno == EINTR || errno == EAGAIN)
+            {
+                // Try again later
+                return true;
+            }
+            else if (errno == ECONNREFUSED || errno == ENOENT)
+            {
+                // the other side is dead
+                return false;
+            }
+            else
+                die("Socket write error: %s", strerror(errno));
+        }
+
+        // Datagrams are sent whole.
+        dest.front_sent += retval;
+        while (!dest.queue.empty()
+               && dest.front_sent >= dest.queue.front().data->size())
+        {
+            dest.front_sent -= dest.queue.front().data->size();
+            dest.queued_bytes -= dest.queue.front().data->size();
+            dest.queue.pop_front();
+        }
+    }
+
+    return true;
+}
+
+// Returns true if everything queued has been sent.
+bool TilesFramework::_flush_queues()
+{
+    for (unsigned int i = 0; i < m_dests.size(); ++i)
+    {
+        if (!_flush_dest(m_dests[i]))
+        {
+            m_dests.erase(m_dests.begin() + i);
+            i--;
+        }
+    }
+    return !_have_queued_messages();
+}
+
+bool TilesFramework::_have_queued_messages() const
+{
+    for (const MessageDest &dest : m_dests)
+        if (!dest.queue.empty())
+            return true;
+    return false;
+}
+
+// Block until the queues are empty or the timeout runs out.
+void TilesFramework::_drain_queues(int timeout_ms)
+{
+    const unsigned int deadline = get_milliseconds() + timeout_ms;
+    while (!_flush_queues())
+    {
+        const int left = (int) (deadline - get_milliseconds());
+        if (left <= 0)
+            break;
+
+        usleep(min(left, 20) * 1000);
     }
-    m_msg_buf.clear();
-    m_need_flush = true;
 }
 
 void TilesFramework::send_message(const char *format, ...)
@@ -268,7 +402,7 @@ void TilesFramework::_await_connection()
     if (m_sock_name.empty())
         return;
 
-    while (m_dest_addrs.size() == 0)
+    while (m_dests.size() == 0)
         _receive_control_message();
 }
 
@@ -318,7 +452,7 @@ wint_t TilesFramework::_handle_control_message(sockaddr_un addr, string data)
         JsonWrapper primary = json_find_member(obj.node, "primary");
         primary.check(JSON_BOOL);
 
-        m_dest_addrs.push_back(addr);
+        _add_dest(addr);
         m_controlled_from_web = primary->bool_;
     }
     else if (msgtype == "key")
@@ -404,7 +538,16 @@ bool TilesFramework::await_input(wint_t& c, bool block)
             if (block)
             {
                 tiles.flush_messages();
-                result = select(maxfd + 1, &fds, nullptr, nullptr, nullptr);
+                // While output is queued, wake up now and then to send
+                // more. (An unconnected datagram socket can't tell us
+                // when a particular receiver has room again.)
+                const bool pending = !m_sock_name.empty()
+                                     && _have_queued_messages();
+                timeval timeout;
+                timeout.tv_sec = 0;
+                timeout.tv_usec = 20 * 1000;
+                result = select(maxfd + 1, &fds, nullptr, nullptr,
+                                pending ? &timeout : nullptr);
             }
             else
             {
@@ -417,8 +560,15 @@ bool TilesFramework::await_input(wint_t& c, bool block)
         }
         while (result == -1 && errno == EINTR);
 
+        if (!m_sock_name.empty() && _have_queued_messages())
+            _flush_queues();
+
         if (result == 0)
+        {
+            if (block)
+                continue;
             return false;
+        }
         else if (result > 0)
         {
             if (!m_sock_name.empty() && FD_ISSET(m_sock, &fds))
@@ -450,6 +600,15 @@ bool TilesFramework::await_input(wint_t& c, bool block)
 void TilesFramework::dump()
 {
     fprintf(stderr, "Webtiles message buffer: %s\n", m_msg_buf.c_str());
+    fprintf(stderr, "Webtiles output queues: %u dropped, %u resyncs\n",
+            m_dropped_frames, m_resyncs);
+    for (const MessageDest &dest : m_dests)
+    {
+        fprintf(stderr, "%s: %u messages (%u bytes), max %u, dropped %u\n",
+                dest.addr.sun_path, (unsigned int) dest.queue.size(),
+                (unsigned int) dest.queued_bytes, dest.max_depth,
+                dest.dropped);
+    }
     fprintf(stderr, "Webtiles JSON stack:\n");
     for (const JsonFrame &frame : m_json_stack)
     {
@@ -1112,6 +1271,88 @@ static inline void _write_tileidx(tileidx_t t)
         tiles.write_message("[%d,%d]", lo, hi);
 }
 
+// The doll or monster cache entry for the foreground of a cell.
+void TilesFramework::_send_cell_doll(const packed_cell &next_pc,
+                                     bool fg_changed)
+{
+    const tileidx_t fg_idx = next_pc.fg & TILE_FLAG_MASK;
+    const bool in_water = _in_water(next_pc);
+
+    if (fg_idx >= TILEP_MCACHE_START)
+    {
+        if (fg_changed)
+        {
+            mcache_entry *entry = mcache.get(fg_idx);
+            if (entry)
+                _send_mcache(entry, in_water);
+            else
+            {
+                json_write_comma();
+                write_message("\"doll\":[[%d,%d]]", TILEP_MONS_UNKNOWN, TILE_Y);
+                json_write_null("mcache");
+            }
+        }
+    }
+    else if (fg_idx == TILEP_PLAYER)
+    {
+        bool player_doll_changed = false;
+        dolls_data result = player_doll;
+        fill_doll_equipment(result);
+        if (result != last_player_doll)
+        {
+            player_doll_changed = true;
+            last_player_doll = result;
+        }
+        if (fg_changed || player_doll_changed)
+        {
+            _send_doll(last_player_doll, in_water, false);
+            if (Options.tile_use_monster != MONS_0)
+            {
+                monster_info minfo(MONS_PLAYER, MONS_PLAYER);
+                minfo.props["monster_tile"] =
+                    short(last_player_doll.parts[TILEP_PART_BASE]);
+                item_def *item;
+                if (you.slot_item(EQ_WEAPON))
+                {
+                    item = new item_def(get_item_info(*you.slot_item(EQ_WEAPON)));
+                    minfo.inv[MSLOT_WEAPON].reset(item);
+                }
+                if (you.slot_item(EQ_SHIELD))
+                {
+                    item = new item_def(get_item_info(*you.slot_item(EQ_SHIELD)));
+                    minfo.inv[MSLOT_SHIELD].reset(item);
+                }
+                tileidx_t mcache_idx = mcache.register_monster(minfo);
+                mcache_entry *entry = mcache.get(mcache_idx);
+                if (entry)
+                    _send_mcache(entry, in_water, false);
+                else
+                    json_write_null("mcache");
+            }
+            else
+                json_write_null("mcache");
+        }
+    }
+    else if (fg_idx >= TILE_MAIN_MAX)
+    {
+        if (fg_changed)
+        {
+            json_write_comma();
+            write_message("\"doll\":[[%u,%d]]", (unsigned int) fg_idx, TILE_Y);
+            json_write_null("mcache");
+        }
+    }
+    else
+    {
+        if (fg_changed)
+        {
+            json_write_comma();
+            json_write_null("doll");
+            json_write_null("mcache");
+        }
+    }
+}
+
 void TilesFramework::_send_cell(const coord_def &gc,
                                 const screen_cell_t &current_sc, const screen_cell_t &next_sc,
                                 const map_cell &current_mc, const map_cell &next_mc,
@@ -1154,7 +1395,6 @@ void TilesFramework::_send_cell(const coord_def &gc,
 
         const tileidx_t fg_idx = next_pc.fg & TILE_FLAG_MASK;
 
-        const bool in_water = _in_water(next_pc);
         bool fg_changed = false;
 
         if (next_pc.fg != current_pc.fg)
@@ -1239,79 +1479,7 @@ void TilesFramework::_send_cell(const coord_def &gc,
             json_close_object();
         }
 
-        if (fg_idx >= TILEP_MCACHE_START)
-        {
-            if (fg_changed)
-            {
-                mcache_entry *entry = mcache.get(fg_idx);
-                if (entry)
-                    _send_mcache(entry, in_water);
-                else
-                {
-                    json_write_comma();
-                    write_message("\"doll\":[[%d,%d]]", TILEP_MONS_UNKNOWN, TILE_Y);
-                    json_write_null("mcache");
-                }
-            }
-        }
-        else if (fg_idx == TILEP_PLAYER)
-        {
-            bool player_doll_changed = false;
-            dolls_data result = player_doll;
-            fill_doll_equipment(result);
-            if (result != last_player_doll)
-            {
-                player_doll_changed = true;
-                last_player_doll = result;
-            }
-            if (fg_changed || player_doll_changed)
-            {
-                _send_doll(last_player_doll, in_water, false);
-                if (Options.tile_use_monster != MONS_0)
-                {
-                    monster_info minfo(MONS_PLAYER, MONS_PLAYER);
-                    minfo.props["monster_tile"] =
-                        short(last_player_doll.parts[TILEP_PART_BASE]);
-                    item_def *item;
-                    if (you.slot_item(EQ_WEAPON))
-                    {
-                        item = new item_def(get_item_info(*you.slot_item(EQ_WEAPON)));
-                        minfo.inv[MSLOT_WEAPON].reset(item);
-                    }
-                    if (you.slot_item(EQ_SHIELD))
-                    {
-                        item = new item_def(get_item_info(*you.slot_item(EQ_SHIELD)));
-                        minfo.inv[MSLOT_SHIELD].reset(item);
-                    }
-                    tileidx_t mcache_idx = mcache.register_monster(minfo);
-                    mcache_entry *entry = mcache.get(mcache_idx);
-                    if (entry)
-                        _send_mcache(entry, in_water, false);
-                    else
-                        json_write_null("mcache");
-                }
-                else
-                    json_write_null("mcache");
-            }
-        }
-        else if (fg_idx >= TILE_MAIN_MAX)
-        {
-            if (fg_changed)
-            {
-                json_write_comma();
-                write_message("\"doll\":[[%u,%d]]", (unsigned int) fg_idx, TILE_Y);
-                json_write_null("mcache");
-            }
-        }
-        else
-        {
-            if (fg_changed)
-            {
-                json_write_comma();
-                json_write_null("doll");
-                json_write_null("mcache");
-            }
-        }
+        _send_cell_doll(next_pc, fg_changed);
 
         bool overlays_changed = false;
 
@@ -1340,6 +1508,250 @@ void TilesFramework::_send_cell(const coord_def &gc,
     json_close_object(true);
 }
 
+/*
+  Binary map frames (the tile_binary_map option) carry the same cell deltas
+  as the "cells" array of a JSON map message, packed and base64 encoded as
+  the "bin" field. All numbers are LEB128 varints; signed ones are zig-zag
+  encoded first. A frame is:
+
+    width, x offset (signed), y offset (signed)
+    then for each cell: skip, field mask, fields
+
+  where skip counts the unsent cells since the previous one in row-major
+  order, and the fields present are packed in the order of
+  binary_cell_field. Tile indices are single 64-bit varints. Monsters and
+  dolls are rare and irregular enough that they go as a length-prefixed
+  JSON object to be merged into the cell. map_knowledge.js decodes this.
+ */
+enum binary_cell_field
+{
+    BCF_FEAT,
+    BCF_MAP_FEAT,
+    BCF_GLYPH,
+    BCF_COLOUR,
+    BCF_FG,
+    BCF_BASE,
+    BCF_BG,
+    BCF_CLOUD,
+    BCF_BLOODY,
+    BCF_OLD_BLOOD,
+    BCF_SILENCED,
+    BCF_HALO,
+    BCF_MOLDY,
+    BCF_GLOWING_MOLD,
+    BCF_SANCTUARY,
+    BCF_LIQUEFIED,
+    BCF_ORB_GLOW,
+    BCF_QUAD_GLOW,
+    BCF_DISJUNCT,
+    BCF_MANGROVE_WATER,
+    BCF_BLOOD_ROTATION,
+    BCF_TRAVEL_TRAIL,
+    BCF_HEAT_AURA,
+    BCF_FLAVOUR,
+    BCF_OVERLAYS,
+    BCF_NO_MONSTER,
+    BCF_JSON,
+};
+
+static void _pack_varint(string &buf, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buf += (char) ((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buf += (char) value;
+}
+
+static void _pack_signed(string &buf, int value)
+{
+    _pack_varint(buf, ((uint32_t) value << 1) ^ (uint32_t) (value >> 31));
+}
+
+static void _pack_field(string &buf, uint32_t &fields, binary_cell_field f,
+                        uint64_t value)
+{
+    fields |= 1 << f;
+    _pack_varint(buf, value);
+}
+
+static void _pack_signed_field(string &buf, uint32_t &fields,
+                               binary_cell_field f, int value)
+{
+    fields |= 1 << f;
+    _pack_signed(buf, value);
+}
+
+static void _write_base64(string &out, const string &in)
+{
+    static const char digits[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    const unsigned char *data = (const unsigned char *) in.data();
+    const size_t len = in.size();
+    out.reserve(out.size() + (len + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 2 < len; i += 3)
+    {
+        const uint32_t v = data[i] << 16 | data[i + 1] << 8 | data[i + 2];
+        out += digits[v >> 18];
+        out += digits[(v >> 12) & 0x3F];
+        out += digits[(v >> 6) & 0x3F];
+        out += digits[v & 0x3F];
+    }
+    if (i < len)
+    {
+        const uint32_t v = data[i] << 16
+                           | (i + 1 < len ? data[i + 1] << 8 : 0);
+        out += digits[v >> 18];
+        out += digits[(v >> 12) & 0x3F];
+        out += i + 1 < len ? digits[(v >> 6) & 0x3F] : '=';
+        out += '=';
+    }
+}
+
+// The binary counterpart of _send_cell(). Appends the field mask and fields
+// to buf and returns true, or leaves it alone if nothing changed.
+bool TilesFramework::_pack_cell(string &buf, const coord_def &gc,
+                                const screen_cell_t &current_sc,
+                                const screen_cell_t &next_sc,
+                                const map_cell &current_mc,
+                                const map_cell &next_mc,
+                                map<uint32_t, coord_def>& new_monster_locs,
+                                bool force_full)
+{
+    string &data = m_bin_fields;
+    data.clear();
+    uint32_t fields = 0;
+
+    if (current_mc.feat() != next_mc.feat())
+        _pack_field(data, fields, BCF_FEAT, next_mc.feat());
+
+    map_feature mf = get_cell_map_feature(next_mc);
+    if (get_cell_map_feature(current_mc) != mf)
+        _pack_field(data, fields, BCF_MAP_FEAT, mf);
+
+    char32_t glyph = next_sc.glyph;
+    if (current_sc.glyph != glyph)
+        _pack_field(data, fields, BCF_GLYPH, glyph);
+    if ((current_sc.colour != next_sc.colour
+         || current_sc.glyph == ' ') && glyph != ' ')
+    {
+        int col = next_sc.colour;
+        col = (_get_brand(col) << 4) | macro_colour(col & 0xF);
+        _pack_field(data, fields, BCF_COLOUR, col);
+    }
+
+    const packed_cell &next_pc = next_sc.tile;
+    const packed_cell &current_pc = current_sc.tile;
+    const tileidx_t fg_idx = next_pc.fg & TILE_FLAG_MASK;
+    const bool fg_changed = next_pc.fg != current_pc.fg;
+
+    if (fg_changed)
+    {
+        _pack_field(data, fields, BCF_FG, next_pc.fg);
+        if (fg_idx && fg_idx <= TILE_MAIN_MAX)
+        {
+            _pack_field(data, fields, BCF_BASE,
+                        tileidx_known_base_item(fg_idx));
+        }
+    }
+    if (next_pc.bg != current_pc.bg)
+        _pack_field(data, fields, BCF_BG, next_pc.bg);
+    if (next_pc.cloud != current_pc.cloud)
+        _pack_field(data, fields, BCF_CLOUD, next_pc.cloud);
+    if (next_pc.is_bloody != current_pc.is_bloody)
+        _pack_field(data, fields, BCF_BLOODY, next_pc.is_bloody);
+    if (next_pc.old_blood != current_pc.old_blood)
+        _pack_field(data, fields, BCF_OLD_BLOOD, next_pc.old_blood);
+    if (next_pc.is_silenced != current_pc.is_silenced)
+        _pack_field(data, fields, BCF_SILENCED, next_pc.is_silenced);
+    if (next_pc.halo != current_pc.halo)
+        _pack_signed_field(data, fields, BCF_HALO, next_pc.halo);
+    if (next_pc.is_moldy != current_pc.is_moldy)
+        _pack_field(data, fields, BCF_MOLDY, next_pc.is_moldy);
+    if (next_pc.glowing_mold != current_pc.glowing_mold)
+        _pack_field(data, fields, BCF_GLOWING_MOLD, next_pc.glowing_mold);
+    if (next_pc.is_sanctuary != current_pc.is_sanctuary)
+        _pack_field(data, fields, BCF_SANCTUARY, next_pc.is_sanctuary);
+    if (next_pc.is_liquefied != current_pc.is_liquefied)
+        _pack_field(data, fields, BCF_LIQUEFIED, next_pc.is_liquefied);
+    if (next_pc.orb_glow != current_pc.orb_glow)
+        _pack_signed_field(data, fields, BCF_ORB_GLOW, next_pc.orb_glow);
+    if (next_pc.quad_glow != current_pc.quad_glow)
+        _pack_field(data, fields, BCF_QUAD_GLOW, next_pc.quad_glow);
+    if (next_pc.disjunct != current_pc.disjunct)
+        _pack_field(data, fields, BCF_DISJUNCT, next_pc.disjunct);
+    if (next_pc.mangrove_water != current_pc.mangrove_water)
+        _pack_field(data, fields, BCF_MANGROVE_WATER, next_pc.mangrove_water);
+    if (next_pc.blood_rotation != current_pc.blood_rotation)
+    {
+        _pack_signed_field(data, fields, BCF_BLOOD_ROTATION,
+                           next_pc.blood_rotation);
+    }
+    if (next_pc.travel_trail != current_pc.travel_trail)
+    {
+        _pack_signed_field(data, fields, BCF_TRAVEL_TRAIL,
+                           next_pc.travel_trail);
+    }
+#if TAG_MAJOR_VERSION == 34
+    if (next_pc.heat_aura != current_pc.heat_aura)
+        _pack_signed_field(data, fields, BCF_HEAT_AURA, next_pc.heat_aura);
+#endif
+
+    if (_needs_flavour(next_pc) &&
+        (next_pc.flv.floor != current_pc.flv.floor
+         || next_pc.flv.special != current_pc.flv.special
+         || !_needs_flavour(current_pc)
+         || force_full))
+    {
+        _pack_field(data, fields, BCF_FLAVOUR, next_pc.flv.floor);
+        _pack_varint(data, next_pc.flv.special);
+    }
+
+    bool overlays_changed =
+        next_pc.num_dngn_overlay != current_pc.num_dngn_overlay;
+    for (int i = 0; !overlays_changed && i < next_pc.num_dngn_overlay; i++)
+        overlays_changed = next_pc.dngn_overlay[i] != current_pc.dngn_overlay[i];
+    if (overlays_changed)
+    {
+        _pack_field(data, fields, BCF_OVERLAYS, next_pc.num_dngn_overlay);
+        for (int i = 0; i < next_pc.num_dngn_overlay; ++i)
+            _pack_signed(data, next_pc.dngn_overlay[i]);
+    }
+
+    if (!next_mc.monsterinfo() && current_mc.monsterinfo())
+        fields |= 1 << BCF_NO_MONSTER;
+
+    // The monster and doll go through the JSON writer, on a buffer of
+    // their own.
+    string &json = m_bin_json;
+    json.clear();
+    m_msg_buf.swap(json);
+    json_open_object();
+    if (next_mc.monsterinfo())
+        _send_monster(gc, next_mc.monsterinfo(), new_monster_locs, force_full);
+    json_open_object("t");
+    _send_cell_doll(next_pc, fg_changed);
+    json_close_object(true);
+    json_close_object(true);
+    m_msg_buf.swap(json);
+
+    if (!json.empty())
+    {
+        _pack_field(data, fields, BCF_JSON, json.size());
+        data += json;
+    }
+
+    if (!fields)
+        return false;
+
+    _pack_varint(buf, fields);
+    buf += data;
+    return true;
+}
+
 void TilesFramework::_send_cursor(cursor_type type)
 {
     if (m_cursor[type] == NO_CURSOR)
@@ -1354,26 +1766,27 @@ void TilesFramework::_send_cursor(cursor_type type)
     }
 }
 
+static void _mcache_ref(const screen_cell_t &cell, bool inc)
+{
+    int fg_idx = cell.tile.fg & TILE_FLAG_MASK;
+    if (fg_idx >= TILEP_MCACHE_START)
+    {
+        mcache_entry *entry = mcache.get(fg_idx);
+        if (entry)
+        {
+            if (inc)
+                entry->inc_ref();
+            else
+                entry->dec_ref();
+        }
+    }
+}
+
 void TilesFramework::_mcache_ref(bool inc)
 {
     for (int y = 0; y < GYM; y++)
         for (int x = 0; x < GXM; x++)
-        {
-            coord_def gc(x, y);
-
-            int fg_idx = m_current_view(gc).tile.fg & TILE_FLAG_MASK;
-            if (fg_idx >= TILEP_MCACHE_START)
-            {
-                mcache_entry *entry = mcache.get(fg_idx);
-                if (entry)
-                {
-                    if (inc)
-                        entry->inc_ref();
-                    else
-                        entry->dec_ref();
-                }
-            }
-        }
+            ::_mcache_ref(m_current_view(coord_def(x, y)), inc);
 }
 
 void TilesFramework::_send_map(bool force_full)
@@ -1415,8 +1828,13 @@ void TilesFramework::_send_map(bool force_full)
 
     coord_def last_gc(0, 0);
     bool send_gc = true;
+    const bool binary = Options.tile_binary_map;
+    string &bin = m_bin_cells;
+    int last_idx = -1;
 
-    json_open_array("cells");
+    bin.clear();
+    if (!binary)
+        json_open_array("cells");
     for (int y = 0; y < GYM; y++)
         for (int x = 0; x < GXM; x++)
         {
@@ -1435,10 +1853,32 @@ void TilesFramework::_send_map(bool force_full)
             }
 
             mark_clean(gc);
+            m_sent_cells.push_back(gc);
 
             if (m_origin.equals(-1, -1))
                 m_origin = gc;
 
+            const screen_cell_t& sc = force_full ? default_cell
+                : m_current_view(gc);
+            const map_cell& mc = force_full ? default_map_cell
+                : m_current_map_knowledge(gc);
+
+            if (binary)
+            {
+                const int idx = y * GXM + x;
+                const size_t start = bin.size();
+                _pack_varint(bin, idx - last_idx - 1);
+                if (_pack_cell(bin, gc, sc, m_next_view(gc),
+                               mc, env.map_knowledge(gc),
+                               new_monster_locs, force_full))
+                {
+                    last_idx = idx;
+                }
+                else
+                    bin.resize(start);
+                continue;
+            }
+
             json_open_object();
             if (send_gc
                 || last_gc.x + 1 != gc.x
@@ -1449,10 +1889,6 @@ void TilesFramework::_send_map(bool force_full)
                 json_treat_as_empty();
             }
 
-            const screen_cell_t& sc = force_full ? default_cell
-                : m_current_view(gc);
-            const map_cell& mc = force_full ? default_map_cell
-                : m_current_map_knowledge(gc);
             _send_cell(gc,
                        sc,
                        m_next_view(gc),
@@ -1466,23 +1902,47 @@ void TilesFramework::_send_map(bool force_full)
             }
             json_close_object(true);
         }
-    json_close_array(true);
+    if (!binary)
+        json_close_array(true);
+    else if (!bin.empty())
+    {
+        string frame;
+        _pack_varint(frame, GXM);
+        _pack_signed(frame, -m_origin.x);
+        _pack_signed(frame, -m_origin.y);
+        frame += bin;
+
+        json_write_name("bin");
+        m_msg_buf += '"';
+        _write_base64(m_msg_buf, frame);
+        m_msg_buf += '"';
+    }
 
     json_close_object(true);
 
+    m_msg_is_map_delta = !force_full;
     finish_message();
 
     if (force_full)
         _send_cursor(CURSOR_MAP);
 
-    if (m_mcache_ref_done)
-        _mcache_ref(false);
-
-    m_current_map_knowledge = env.map_knowledge;
-    m_current_view = m_next_view;
+    // Only the cells just sent have changed on the client.
+    for (const coord_def &gc : m_sent_cells)
+    {
+        if (m_mcache_ref_done)
+            ::_mcache_ref(m_current_view(gc), false);
+        m_current_view(gc) = m_next_view(gc);
+        m_current_map_knowledge(gc) = env.map_knowledge(gc);
+        if (m_mcache_ref_done)
+            ::_mcache_ref(m_current_view(gc), true);
+    }
+    m_sent_cells.clear();
 
-    _mcache_ref(true);
-    m_mcache_ref_done = true;
+    if (!m_mcache_ref_done)
+    {
+        _mcache_ref(true);
+        m_mcache_ref_done = true;
+    }
 
     m_monster_locs = new_monster_locs;
 }
@@ -1737,6 +2197,13 @@ void TilesFramework::redraw()
         return;
     }
 
+    if (m_need_resync)
+    {
+        // A receiver fell too far behind and lost messages.
+        m_need_resync = false;
+        _send_everything();
+    }
+
     if (m_layout_reset)
     {
         _send_layout();
@@ -7,7 +7,9 @@
 #define TILEWEB_H
 
 #include <bitset>
+#include <deque>
 #include <map>
+#include <memory>
 #include <sys/un.h>
 
 #include "map_knowledge.h"
@@ -144,7 +146,7 @@ public:
     void send_message(PRINTF(1, ));
     void flush_messages();
 
-    bool has_receivers() { return !m_dest_addrs.empty(); }
+    bool has_receivers() { return !m_dests.empty(); }
     bool is_controlled_from_web() { return m_controlled_from_web; }
 
     /* Webtiles can receive input both via stdin, and on the
@@ -207,11 +209,40 @@ protected:
     int m_sock;
     int m_max_msg_size;
     string m_msg_buf;
-    vector<sockaddr_un> m_dest_addrs;
+
+    // Outgoing messages are queued per receiver and written out without
+    // blocking, so that a slow reader can't stall the game.
+    struct QueuedMessage
+    {
+        shared_ptr<const string> data;
+        bool map_delta; // Can be dropped in favour of a later full map.
+    };
+    struct MessageDest
+    {
+        sockaddr_un addr;
+        deque<QueuedMessage> queue;
+        size_t queued_bytes;
+        size_t front_sent; // Bytes of queue.front() already sent.
+        unsigned int max_depth;
+        unsigned int dropped;
+    };
+    vector<MessageDest> m_dests;
+    string m_datagram;
+    bool m_msg_is_map_delta;
+    bool m_need_resync;
+    unsigned int m_dropped_frames;
+    unsigned int m_resyncs;
 
     bool m_controlled_from_web;
     bool m_need_flush;
 
+    void _add_dest(const sockaddr_un &addr);
+    void _queue_message(MessageDest &dest, const QueuedMessage &msg);
+    bool _flush_dest(MessageDest &dest);
+    bool _flush_queues();
+    bool _have_queued_messages() const;
+    void _drain_queues(int timeout_ms);
+
     void _await_connection();
     wint_t _handle_control_message(sockaddr_un addr, string data);
     wint_t _receive_control_message();
@@ -297,6 +328,13 @@ protected:
     bool m_mcache_ref_done;
     void _mcache_ref(bool inc);
 
+    // Cells sent by the current _send_map(), and scratch space for
+    // binary map frames.
+    vector<coord_def> m_sent_cells;
+    string m_bin_cells;
+    string m_bin_fields;
+    string m_bin_json;
+
     void _send_cursor(cursor_type type);
     void _send_map(bool force_full = false);
     void _send_cell(const coord_def &gc,
@@ -304,6 +342,12 @@ protected:
                     const map_cell &current_mc, const map_cell &next_mc,
                     map<uint32_t, coord_def>& new_monster_locs,
                     bool force_full);
+    void _send_cell_doll(const packed_cell &next_pc, bool fg_changed);
+    bool _pack_cell(string &buf, const coord_def &gc,
+                    const screen_cell_t &current_sc, const screen_cell_t &next_sc,
+                    const map_cell &current_mc, const map_cell &next_mc,
+                    map<uint32_t, coord_def>& new_monster_locs,
+                    bool force_full);
     void _send_monster(const coord_def &gc, const monster_info* m,
                        map<uint32_t, coord_def>& new_monster_locs,
                        bool force_full);
@@ -1811,6 +1811,7 @@ bool transform(int pow, transformation_type which_trans, bool involuntary,
     you.form = which_trans;
     you.set_duration(DUR_TRANSFORMATION, _transform_duration(which_trans, pow));
     update_player_symbol();
+    invalidate_autopickup_cache();
 
     _remove_equipment(rem_stuff);
 
@@ -2006,6 +2007,7 @@ void untransform(bool skip_move)
     you.form = TRAN_NONE;
     you.duration[DUR_TRANSFORMATION] = 0;
     update_player_symbol();
+    invalidate_autopickup_cache();
 
     if (old_form == TRAN_APPENDAGE)
     {
@@ -80,6 +80,7 @@ void trap_def::destroy(bool known)
     if (known)
     {
         env.map_knowledge(pos).set_feature(DNGN_FLOOR);
+        update_travel_region_cell(pos);
         StashTrack.update_stash(pos);
     }
     env.trap.erase(pos);
@@ -575,6 +576,7 @@ void trap_def::trigger(actor& triggerer)
             if (in_sight)
             {
                 env.map_knowledge(pos).set_feature(DNGN_FLOOR);
+                update_travel_region_cell(pos);
                 mprf("%s disappears.", name(DESC_THE).c_str());
             }
             destroy();
@@ -14,7 +14,9 @@
 #include <cctype>
 #include <cstdarg>
 #include <cstdio>
+#include <functional>
 #include <memory>
+#include <queue>
 #include <set>
 #include <sstream>
 
@@ -493,6 +495,7 @@ static bool _is_safe_move(const coord_def& c)
 
 void travel_init_load_level()
 {
+    invalidate_travel_regions();
     curr_excludes.clear();
     travel_cache.set_level_excludes();
     travel_cache.update_waypoints();
@@ -1011,11 +1014,544 @@ static void _fill_exclude_radius(const travel_exclude &exc)
         }
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// travel_region_graph
+//
+// A coarse map of the level for travel. The level is cut into square
+// regions; neighbouring regions are joined at one transition cell in the
+// middle of each open stretch of their shared border, and the transitions
+// of a region are joined by the cheapest path between them that stays
+// inside it. Searching this graph is cheap and finds a real, if not always
+// the shortest, path, whose cost travel_pathfind::pathfind() then uses to
+// bound its flood.
+//
+// The graph only knows about the map and exclusions, so the path it finds
+// may turn out to be blocked (by a monster, say); the flood copes with that.
+// It is kept until the level changes: whatever updates the map knowledge of
+// a cell reports it through update_travel_region_cell(), and only the
+// regions around cells that changed are rebuilt.
+
+#define REGION_SIZE 10
+#define REGIONS_X ((GXM + REGION_SIZE - 1) / REGION_SIZE)
+#define REGIONS_Y ((GYM + REGION_SIZE - 1) / REGION_SIZE)
+
+typedef FixedArray<int, REGION_SIZE, REGION_SIZE> region_dist_grid;
+typedef pair<int, coord_def> region_node;
+typedef priority_queue<region_node, vector<region_node>,
+                       greater<region_node> > region_queue;
+
+// What the graph remembers about a cell.
+enum region_cell_flag_type
+{
+    RCELL_COST   = 0x03, // The cost of stepping there, 0 if travel won't.
+    RCELL_OPEN   = 0x04, // Travel might step there, at a pinch.
+    RCELL_UNSEEN = 0x08, // Never seen, so explore wants a look at it.
+};
+
+struct travel_region
+{
+    // Transition cells, the cell across the border each one leads to, the
+    // cost of the cheapest path from one transition to another, and from
+    // each transition to the nearest frontier cell of the region.
+    vector<coord_def> nodes;
+    vector<coord_def> exits;
+    vector<int> cost;
+    vector<int> frontier_cost;
+};
+
+class travel_region_graph
+{
+public:
+    travel_region_graph() : valid(false) { }
+
+    void invalidate() { valid = false; }
+    void update_cell(const coord_def &c);
+    int path_cost(const coord_def &from, const coord_def &to);
+    int explore_cost(const coord_def &from, const vector<coord_def> &greed);
+    void explore_distances(const coord_def &from,
+                           const vector<coord_def> &greed,
+                           FixedArray<int, GXM, GYM> &dist) const;
+
+private:
+    void update();
+    void build_region(int rx, int ry);
+    void add_transitions(travel_region &reg, coord_def p,
+                         const coord_def &step, const coord_def &across,
+                         int len);
+    void region_costs(const coord_def &src, const coord_def &free,
+                      bool reverse, region_dist_grid &dist) const;
+    void target_costs(const coord_def &tl, const vector<coord_def> &targets,
+                      region_dist_grid &dist) const;
+    template<class F>
+    int search(const coord_def &from, const region_dist_grid &from_dist,
+               int best, F finish) const;
+
+    int cost(const coord_def &c) const { return cell(c) & RCELL_COST; }
+    bool current() const { return valid && level == level_id::current(); }
+
+    bool valid;
+    // The level the graph was built for; any other needs a full rebuild.
+    level_id level;
+    FixedArray<uint8_t, GXM, GYM> cell;
+    // Cells travel might step onto next to ones never seen.
+    FixedArray<bool, GXM, GYM> is_frontier;
+    FixedArray<bool, REGIONS_X, REGIONS_Y> dirty;
+    FixedArray<travel_region, REGIONS_X, REGIONS_Y> regions;
+};
+
+static travel_region_graph _travel_regions;
+
+static coord_def _region_of(const coord_def &c)
+{
+    return coord_def(c.x / REGION_SIZE, c.y / REGION_SIZE);
+}
+
+static coord_def _region_origin(const coord_def &c)
+{
+    return _region_of(c) * REGION_SIZE;
+}
+
+static bool _in_region(const coord_def &c, const coord_def &origin)
+{
+    return c.x >= origin.x && c.y >= origin.y
+           && c.x < min(origin.x + REGION_SIZE, GXM)
+           && c.y < min(origin.y + REGION_SIZE, GYM);
+}
+
+static uint8_t _region_cell(const coord_def &c)
+{
+    if (!in_bounds(c))
+        return 0;
+
+    const map_cell &mc = env.map_knowledge(c);
+    uint8_t flags = mc.seen() ? 0 : RCELL_UNSEEN;
+    if (!mc.known())
+        return flags;
+
+    const dungeon_feature_type feat = mc.feat();
+    if (feat_is_traversable_now(feat, true) || feat_is_trap(feat))
+        flags |= RCELL_OPEN;
+
+    // The cost of stepping onto c, as travel reckons it, or 0 if travel
+    // would never step there whatever monsters or clouds are about.
+    if (feat != DNGN_RUNED_DOOR && feat_is_traversable_now(feat)
+        && (!is_excluded(c) || is_stair_exclusion(c)))
+    {
+        flags |= _feature_traverse_cost(feat);
+    }
+
+    return flags;
+}
+
+void invalidate_travel_regions()
+{
+    _travel_regions.invalidate();
+}
+
+void update_travel_region_cell(const coord_def &c)
+{
+    _travel_regions.update_cell(c);
+}
+
+void travel_region_graph::update_cell(const coord_def &c)
+{
+    if (!current())
+        return;
+
+    const uint8_t flags = _region_cell(c);
+    if (flags == cell(c))
+        return;
+    cell(c) = flags;
+
+    // The transitions and frontier of the neighbours' regions may have
+    // moved too.
+    for (int x = max(c.x - 1, 0); x <= min(c.x + 1, GXM - 1); ++x)
+        for (int y = max(c.y - 1, 0); y <= min(c.y + 1, GYM - 1); ++y)
+            dirty(_region_of(coord_def(x, y))) = true;
+}
+
+void travel_region_graph::update()
+{
+    if (!current())
+    {
+        for (int x = 0; x < GXM; ++x)
+            for (int y = 0; y < GYM; ++y)
+                cell[x][y] = _region_cell(coord_def(x, y));
+        dirty.init(true);
+        valid = true;
+        level = level_id::current();
+    }
+
+    for (int rx = 0; rx < REGIONS_X; ++rx)
+        for (int ry = 0; ry < REGIONS_Y; ++ry)
+            if (dirty[rx][ry])
+            {
+                build_region(rx, ry);
+                dirty[rx][ry] = false;
+            }
+}
+
+// Walk len cells from p along a region's edge, adding a transition for
+// each stretch where both p and the cell across the border are passable.
+void travel_region_graph::add_transitions(travel_region &reg, coord_def p,
+                                          const coord_def &step,
+                                          const coord_def &across, int len)
+{
+    int run = 0;
+    for (int i = 0; i <= len; ++i, p += step)
+    {
+        if (i < len && cost(p) && cost(p + across))
+        {
+            ++run;
+            continue;
+        }
+
+        if (run)
+        {
+            const coord_def mid = p - step * ((run + 1) / 2);
+            reg.nodes.push_back(mid);
+            reg.exits.push_back(mid + across);
+            run = 0;
+        }
+    }
+}
+
+void travel_region_graph::build_region(int rx, int ry)
+{
+    travel_region &reg = regions[rx][ry];
+    reg.nodes.clear();
+    reg.exits.clear();
+
+    const coord_def tl(rx * REGION_SIZE, ry * REGION_SIZE);
+    const coord_def br(min(tl.x + REGION_SIZE, GXM) - 1,
+                       min(tl.y + REGION_SIZE, GYM) - 1);
+    const int width = br.x - tl.x + 1, height = br.y - tl.y + 1;
+
+    vector<coord_def> targets;
+    for (int x = tl.x; x <= br.x; ++x)
+        for (int y = tl.y; y <= br.y; ++y)
+        {
+            const coord_def c(x, y);
+            is_frontier(c) = false;
+            if (!(cell(c) & RCELL_OPEN))
+                continue;
+
+            for (adjacent_iterator ai(c); ai; ++ai)
+                if (map_bounds(*ai) && (cell(*ai) & RCELL_UNSEEN))
+                {
+                    is_frontier(c) = true;
+                    if (cost(c))
+                        targets.push_back(c);
+                    break;
+                }
+        }
+
+    if (rx > 0)
+        add_transitions(reg, tl, coord_def(0, 1), coord_def(-1, 0), height);
+    if (rx < REGIONS_X - 1)
+    {
+        add_transitions(reg, coord_def(br.x, tl.y), coord_def(0, 1),
+                        coord_def(1, 0), height);
+    }
+    if (ry > 0)
+        add_transitions(reg, tl, coord_def(1, 0), coord_def(0, -1), width);
+    if (ry < REGIONS_Y - 1)
+    {
+        add_transitions(reg, coord_def(tl.x, br.y), coord_def(1, 0),
+                        coord_def(0, 1), width);
+    }
+
+    const int n = reg.nodes.size();
+    reg.cost.resize(n * n);
+    region_dist_grid dist;
+    for (int i = 0; i < n; ++i)
+    {
+        region_costs(reg.nodes[i], reg.nodes[i], false, dist);
+        for (int j = 0; j < n; ++j)
+            reg.cost[i * n + j] = dist(reg.nodes[j] - tl);
+    }
+
+    reg.frontier_cost.resize(n);
+    target_costs(tl, targets, dist);
+    for (int i = 0; i < n; ++i)
+        reg.frontier_cost[i] = dist(reg.nodes[i] - tl);
+}
+
+// Dijkstra's algorithm within src's region. Going forward, finds the cost
+// of getting from src to each cell, paying for every cell stepped onto but
+// free; free may be impassable, and is never stepped off. In reverse, finds
+// the cost of getting from each cell to src, not paying for src itself.
+void travel_region_graph::region_costs(const coord_def &src,
+                                       const coord_def &free, bool reverse,
+                                       region_dist_grid &dist) const
+{
+    const coord_def tl = _region_origin(src);
+    dist.init(INFINITE_DISTANCE);
+    dist(src - tl) = 0;
+
+    region_queue open;
+    open.emplace(0, src);
+    while (!open.empty())
+    {
+        const region_node node = open.top();
+        open.pop();
+        const coord_def p = node.second;
+        if (node.first > dist(p - tl))
+            continue;
+
+        const int charge = reverse && p != src ? cost(p) : 0;
+        for (adjacent_iterator ai(p); ai; ++ai)
+        {
+            const coord_def q = *ai;
+            if (!_in_region(q, tl))
+                continue;
+
+            // Can we step onto q, and off again?
+            const bool passable = cost(q) && (reverse || q != free);
+            if (!reverse && !passable && q != free)
+                continue;
+
+            const int d = node.first + (reverse     ? charge :
+                                        q == free   ? 0
+                                                    : cost(q));
+            if (d >= dist(q - tl))
+                continue;
+
+            dist(q - tl) = d;
+            if (passable)
+                open.emplace(d, q);
+        }
+    }
+}
+
+// Dijkstra's algorithm within the region at tl, backwards from several
+// passable targets at once: finds the cost of getting from each cell to the
+// nearest of them, paying for every cell stepped onto.
+void travel_region_graph::target_costs(const coord_def &tl,
+                                       const vector<coord_def> &targets,
+                                       region_dist_grid &dist) const
+{
+    dist.init(INFINITE_DISTANCE);
+
+    region_queue open;
+    for (const coord_def &t : targets)
+    {
+        dist(t - tl) = 0;
+        open.emplace(0, t);
+    }
+
+    while (!open.empty())
+    {
+        const region_node node = open.top();
+        open.pop();
+        const coord_def p = node.second;
+        if (node.first > dist(p - tl))
+            continue;
+
+        const int d = node.first + cost(p);
+        for (adjacent_iterator ai(p); ai; ++ai)
+        {
+            const coord_def q = *ai;
+            if (!_in_region(q, tl) || !cost(q) || d >= dist(q - tl))
+                continue;
+
+            dist(q - tl) = d;
+            open.emplace(d, q);
+        }
+    }
+}
+
+// Dijkstra's algorithm over the transitions, starting from those of from's
+// region at the costs in from_dist. finish(i, p) is the cost of getting from
+// p, transition i of its region, to the goal; best is the cost of a path
+// found without leaving from's region. Returns the cost of the cheapest
+// path to the goal.
+template<class F>
+int travel_region_graph::search(const coord_def &from,
+                                const region_dist_grid &from_dist, int best,
+                                F finish) const
+{
+    const coord_def ftl = _region_origin(from);
+
+    FixedArray<int, GXM, GYM> dist(INFINITE_DISTANCE);
+    region_queue open;
+    auto relax = [&](const coord_def &p, int d)
+    {
+        if (d < dist(p))
+        {
+            dist(p) = d;
+            open.emplace(d, p);
+        }
+    };
+
+    const travel_region &start = regions(_region_of(from));
+    for (const coord_def &p : start.nodes)
+        if (from_dist(p - ftl) < INFINITE_DISTANCE)
+            relax(p, from_dist(p - ftl));
+
+    while (!open.empty())
+    {
+        const region_node node = open.top();
+        open.pop();
+        const coord_def p = node.second;
+        if (node.first > dist(p))
+            continue;
+        if (node.first >= best)
+            break;
+
+        const travel_region &reg = regions(_region_of(p));
+        const int n = reg.nodes.size();
+        for (int i = 0; i < n; ++i)
+        {
+            if (reg.nodes[i] != p)
+                continue;
+
+            const int rest = finish(i, p);
+            if (rest < INFINITE_DISTANCE)
+                best = min(best, node.first + rest);
+
+            for (int j = 0; j < n; ++j)
+                if (reg.cost[i * n + j] < INFINITE_DISTANCE)
+                    relax(reg.nodes[j], node.first + reg.cost[i * n + j]);
+
+            relax(reg.exits[i], node.first + cost(reg.exits[i]));
+        }
+    }
+
+    return best;
+}
+
+// The cost of the cheapest path the graph knows from one cell to another,
+// paying for every cell stepped onto except the last, or INFINITE_DISTANCE
+// if it knows none.
+int travel_region_graph::path_cost(const coord_def &from, const coord_def &to)
+{
+    update();
+
+    region_dist_grid from_dist, to_dist;
+    region_costs(from, to, false, from_dist);
+    region_costs(to, to, true, to_dist);
+    const coord_def ftl = _region_origin(from), ttl = _region_origin(to);
+
+    return search(from, from_dist,
+                  _in_region(to, ftl) ? from_dist(to - ftl)
+                                      : INFINITE_DISTANCE,
+                  [&](int, const coord_def &p)
+                  {
+                      return _in_region(p, ttl) ? to_dist(p - ttl)
+                                                : INFINITE_DISTANCE;
+                  });
+}
+
+// The cost of the cheapest path the graph knows from a cell to either a
+// frontier cell or one of the greed squares, paying for every cell stepped
+// onto, or INFINITE_DISTANCE if it knows none.
+int travel_region_graph::explore_cost(const coord_def &from,
+                                      const vector<coord_def> &greed)
+{
+    update();
+
+    region_dist_grid from_dist;
+    region_costs(from, from, false, from_dist);
+    const coord_def ftl = _region_origin(from);
+
+    int best = INFINITE_DISTANCE;
+    for (int x = ftl.x; x < min(ftl.x + REGION_SIZE, GXM); ++x)
+        for (int y = ftl.y; y < min(ftl.y + REGION_SIZE, GYM); ++y)
+            if (is_frontier[x][y] && cost(coord_def(x, y)))
+                best = min(best, from_dist[x - ftl.x][y - ftl.y]);
+
+    // Greed squares come and go with the items on them, so their costs
+    // are worked out afresh, for the few regions that have any.
+    FixedArray<int, GXM, GYM> greed_cost(INFINITE_DISTANCE);
+    vector<coord_def> targets;
+    for (const coord_def &g : greed)
+    {
+        if (!in_bounds(g) || !cost(g)
+            || greed_cost(g) != INFINITE_DISTANCE)
+        {
+            continue;
+        }
+
+        const coord_def tl = _region_origin(g);
+        targets.clear();
+        for (const coord_def &h : greed)
+            if (in_bounds(h) && cost(h) && _in_region(h, tl))
+                targets.push_back(h);
+
+        region_dist_grid dist;
+        target_costs(tl, targets, dist);
+        for (int x = tl.x; x < min(tl.x + REGION_SIZE, GXM); ++x)
+            for (int y = tl.y; y < min(tl.y + REGION_SIZE, GYM); ++y)
+                greed_cost[x][y] = dist[x - tl.x][y - tl.y];
+
+        if (tl == ftl)
+            for (const coord_def &h : targets)
+                best = min(best, from_dist(h - ftl));
+    }
+
+    return search(from, from_dist, best,
+                  [&](int i, const coord_def &p)
+                  {
+                      return min(regions(_region_of(p)).frontier_cost[i],
+                                 greed_cost(p));
+                  });
+}
+
+// How many steps, ignoring walls, each cell is from the nearest cell explore
+// could stop at: a frontier cell, a greed square, or the start of the flood.
+// Only good after explore_cost() has brought the graph up to date.
+void travel_region_graph::explore_distances(const coord_def &from,
+                                            const vector<coord_def> &greed,
+                                            FixedArray<int, GXM, GYM> &dist)
+                                            const
+{
+    for (int x = 0; x < GXM; ++x)
+        for (int y = 0; y < GYM; ++y)
+            dist[x][y] = is_frontier[x][y] ? 0 : INFINITE_DISTANCE;
+
+    dist(from) = 0;
+    for (const coord_def &g : greed)
+        if (map_bounds(g))
+            dist(g) = 0;
+
+    // Two raster passes give exact distances where every step costs one.
+    for (int y = 0; y < GYM; ++y)
+        for (int x = 0; x < GXM; ++x)
+        {
+            int &d = dist[x][y];
+            if (x > 0)
+                d = min(d, dist[x - 1][y] + 1);
+            if (y > 0)
+            {
+                for (int dx = max(x - 1, 0); dx <= min(x + 1, GXM - 1); ++dx)
+                    d = min(d, dist[dx][y - 1] + 1);
+            }
+        }
+
+    for (int y = GYM - 1; y >= 0; --y)
+        for (int x = GXM - 1; x >= 0; --x)
+        {
+            int &d = dist[x][y];
+            if (x < GXM - 1)
+                d = min(d, dist[x + 1][y] + 1);
+            if (y < GYM - 1)
+            {
+                for (int dx = max(x - 1, 0); dx <= min(x + 1, GXM - 1); ++dx)
+                    d = min(d, dist[dx][y + 1] + 1);
+            }
+        }
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // travel_pathfind
 
 FixedVector<coord_def, GXM * GYM> travel_pathfind::circumference[2];
 
+// For a bounded explore, how far each square is from the nearest thing
+// explore could stop at; see travel_region_graph::explore_distances().
+static FixedArray<int, GXM, GYM> _explore_target_dist;
+
 // already defined in header
 // const int travel_pathfind::UNFOUND_DIST;
 // const int travel_pathfind::INFINITE_DIST;
@@ -1028,7 +1564,8 @@ travel_pathfind::travel_pathfind()
       unexplored_place(), greedy_place(), unexplored_dist(0), greedy_dist(0),
       refdist(nullptr), reseed_points(), features(nullptr), unreachables(),
       point_distance(travel_point_distance), points(0), next_iter_points(0),
-      traveled_distance(0), circ_index(0)
+      traveled_distance(0), circ_index(0), path_bound(0), deferred(),
+      replayed(0)
 {
 }
 
@@ -1227,11 +1764,54 @@ coord_def travel_pathfind::pathfind(run_mode_type rmode, bool fallback_explore)
     // next round in next_iter_points, we don't even need to reset the array.
     circumference[circ_index][0] = start;
 
+    // The cost of a path through the region graph limits how far the flood
+    // needs to look; see beyond_bound(). With a wall bias, explore's choice
+    // depends on the order squares are found in, so it gets no bound.
+    path_bound = 0;
+    deferred.clear();
+    replayed = 0;
+    if (!features && !annotate_map)
+    {
+        if (runmode == RMODE_TRAVEL && !floodout)
+        {
+            const int cost = _travel_regions.path_cost(start, dest);
+            if (cost != INFINITE_DISTANCE)
+                path_bound = cost + 1;
+        }
+        else if ((runmode == RMODE_EXPLORE || runmode == RMODE_EXPLORE_GREEDY)
+                 && floodout && !Options.explore_wall_bias)
+        {
+            vector<coord_def> greed;
+            if (need_for_greed && ls)
+                ls->get_visit_squares(greed, autopickup);
+
+            const int cost = _travel_regions.explore_cost(start, greed);
+            if (cost != INFINITE_DISTANCE)
+            {
+                // Item greed is added to the distance of one kind of target.
+                path_bound = cost + 1;
+                if (need_for_greed)
+                    path_bound += abs(Options.explore_item_greed);
+                _travel_regions.explore_distances(start, greed,
+                                                  _explore_target_dist);
+            }
+        }
+    }
+
     bool found_target = false;
 
-    for (; points > 0; ++traveled_distance, circ_index = !circ_index,
-                        points = next_iter_points, next_iter_points = 0)
+    for (; points > 0 || !path_bound && replayed < deferred.size();
+         ++traveled_distance, circ_index = !circ_index,
+         points = next_iter_points, next_iter_points = 0)
     {
+        // Once the bound has been lifted, the squares it set aside rejoin
+        // the flood at the travel time they were reached at.
+        for (; !path_bound && replayed < deferred.size()
+               && deferred[replayed].first == traveled_distance; ++replayed)
+        {
+            circumference[circ_index][points++] = deferred[replayed].second;
+        }
+
         for (int i = 0; i < points; ++i)
         {
             // Look at all neighbours of the current grid.
@@ -1252,9 +1832,14 @@ coord_def travel_pathfind::pathfind(run_mode_type rmode, bool fallback_explore)
         if (next_iter_points == 0 && found_target)
             return explore_target();
 
+        // The flood has run dry within the bound without finding anything
+        // within it, so the path the bound came from must be blocked.
+        if (next_iter_points == 0 && path_bound && lift_bound())
+            continue;
+
         // If there are no more points to look at, we're done, but we did
         // not find a path to our target.
-        if (next_iter_points == 0)
+        if (next_iter_points == 0 && replayed == deferred.size())
         {
             // Don't reseed unless we've found no target for explore, OR
             // we're doing map annotation or feature tracking.
@@ -1371,9 +1956,60 @@ bool travel_pathfind::square_slows_movement(const coord_def &c)
     return false;
 }
 
+// Squares are examined in order of travel time, so if no path through c can
+// reach dest, or anything explore could stop at, within the bound, nothing
+// it leads to can beat the path the bound came from.
+bool travel_pathfind::beyond_bound(const coord_def &c) const
+{
+    if (!path_bound)
+        return false;
+
+    if (runmode == RMODE_TRAVEL)
+        return traveled_distance + grid_distance(c, dest) - 1 > path_bound;
+
+    return traveled_distance + _explore_target_dist(c) > path_bound;
+}
+
+bool travel_pathfind::bound_lifted() const
+{
+    return !path_bound && !deferred.empty();
+}
+
+// Has explore found something within the bound, which nothing set aside
+// could beat? Once the bound has been lifted, squares are no longer found
+// in order of travel time, so nothing is certain until the flood is done.
+bool travel_pathfind::explore_bound_met() const
+{
+    if (!path_bound)
+        return deferred.empty();
+
+    int best = INFINITE_DIST;
+    if (unexplored_dist != UNFOUND_DIST)
+        best = min(best, unexplored_dist);
+    if (greedy_dist != UNFOUND_DIST)
+        best = min(best, greedy_dist);
+    return best <= path_bound;
+}
+
+// Called when the bounded flood has run dry. Returns true if the flood
+// should go back to the squares the bound set aside.
+bool travel_pathfind::lift_bound()
+{
+    if (runmode != RMODE_TRAVEL && explore_bound_met())
+        return false;
+
+    path_bound = 0;
+    if (deferred.empty())
+        return false;
+
+    // The for loop's step takes us to the first square set aside.
+    traveled_distance = deferred[0].first - 1;
+    return true;
+}
+
 void travel_pathfind::check_square_greed(const coord_def &c)
 {
-    if (greedy_dist == UNFOUND_DIST
+    if ((greedy_dist == UNFOUND_DIST || bound_lifted())
         && is_greed_inducing_square(c)
         && _is_travelsafe_square(c, ignore_hostile, ignore_danger))
     {
@@ -1388,8 +2024,13 @@ void travel_pathfind::check_square_greed(const coord_def &c)
         if (Options.explore_wall_bias)
             dist += Options.explore_wall_bias * 3;
 
-        greedy_dist = dist;
-        greedy_place = c;
+        // After the bound has been lifted, a square found later may still
+        // be nearer.
+        if (greedy_dist == UNFOUND_DIST || dist < greedy_dist)
+        {
+            greedy_dist = dist;
+            greedy_place = c;
+        }
     }
 }
 
@@ -1477,11 +2118,13 @@ bool travel_pathfind::path_flood(const coord_def &c, const coord_def &dc)
         //
         // We never short-circuit if ignore_hostile is true. This is
         // important so we don't need to do multiple floods to work out
-        // whether explore is complete.
+        // whether explore is complete. Nor do we while a target outside
+        // the bound might yet be beaten by one the bound set aside.
         if (need_for_greed
             && !ignore_hostile
             && *refdist != UNFOUND_DIST
-            && traveled_distance > *refdist)
+            && traveled_distance > *refdist
+            && (path_bound ? *refdist <= path_bound : !bound_lifted()))
         {
             if (Options.explore_item_greed > 0)
                 greedy_dist = INFINITE_DIST;
@@ -1491,8 +2134,11 @@ bool travel_pathfind::path_flood(const coord_def &c, const coord_def &dc)
 
         // greedy_dist is only ever set in greedy-explore so this check
         // implies greedy-explore.
-        if (unexplored_dist != UNFOUND_DIST && greedy_dist != UNFOUND_DIST)
+        if (unexplored_dist != UNFOUND_DIST && greedy_dist != UNFOUND_DIST
+            && explore_bound_met())
+        {
             return true;
+        }
     }
 
     if (dc == dest)
@@ -1574,6 +2220,16 @@ bool travel_pathfind::path_flood(const coord_def &c, const coord_def &dc)
             features->push_back(dc);
         }
     }
+    // While the bound was in place, the flood went on past the squares it
+    // set aside, so squares found then may have a shorter way through one
+    // of those. Replaying them brings such squares forward, and they are
+    // looked at again from their new travel time.
+    else if (bound_lifted() && !ignore_hostile
+             && point_distance[dc.x][dc.y] > traveled_distance)
+    {
+        circumference[!circ_index][next_iter_points++] = dc;
+        point_distance[dc.x][dc.y] = traveled_distance;
+    }
 
     return false;
 }
@@ -1610,6 +2266,12 @@ bool travel_pathfind::path_examine_point(const coord_def &c)
     if (!in_bounds(c))
         return false;
 
+    if (beyond_bound(c))
+    {
+        deferred.emplace_back(traveled_distance, c);
+        return false;
+    }
+
     if (point_traverse_delay(c))
         return false;
 
@@ -56,6 +56,8 @@ enum run_mode_type
 void stop_running(bool clear_delays = true);
 void travel_init_load_level();
 void travel_init_new_level();
+void invalidate_travel_regions();
+void update_travel_region_cell(const coord_def &c);
 
 uint8_t is_waypoint(const coord_def &p);
 command_type direction_to_command(int x, int y);
@@ -498,6 +500,10 @@ protected:
     virtual bool point_traverse_delay(const coord_def &c);
     virtual bool path_flood(const coord_def &c, const coord_def &dc);
     bool square_slows_movement(const coord_def &c);
+    bool beyond_bound(const coord_def &c) const;
+    bool bound_lifted() const;
+    bool explore_bound_met() const;
+    bool lift_bound();
     void check_square_greed(const coord_def &c);
     void good_square(const coord_def &c);
 
@@ -582,6 +588,14 @@ protected:
     // Attempt to path through temporary obstructions (like sealed doors)
     // due to the possibility they are no longer obstructing us
     bool try_fallback;
+
+    // The travel time of a known path from start to dest, or to something
+    // explore could stop at; squares that can't beat it are set aside in
+    // deferred, with the travel time they were reached at, and only looked
+    // at if the path turns out to be blocked. Zero if there is no bound.
+    int path_bound;
+    vector<pair<int, coord_def> > deferred;
+    size_t replayed;
 };
 
 extern TravelCache travel_cache;
@@ -652,6 +652,7 @@ bool magic_mapping(int map_radius, int proportion, bool suppress_msg,
             }
             else
                 env.map_knowledge(*ri).clear();
+            update_travel_region_cell(*ri);
         }
 
         if (!wizard_map && (env.map_knowledge(*ri).seen() || env.map_knowledge(*ri).mapped()))
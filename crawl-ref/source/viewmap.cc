@@ -585,6 +585,7 @@ static void _unforget_map()
             tiles.update_minimap(*ri);
 #endif
         }
+    invalidate_travel_regions();
 }
 
 static void _forget_map()
@@ -600,6 +601,7 @@ static void _forget_map()
         tiles.update_minimap(*ri);
 #endif
     }
+    invalidate_travel_regions();
 }
 
 // show_map() now centers the known map along x or y. This prevents
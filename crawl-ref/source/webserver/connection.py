@@ -82,7 +82,9 @@ class WebtilesSocketConnection(object):
             self.msg_buffer = None
 
             if self.message_callback:
-                self.message_callback(data)
+                # Several messages may arrive in one datagram.
+                for msg in data.split("\n")[:-1]:
+                    self.message_callback(msg + "\n")
 
     def send_message(self, data):
         start = datetime.now()
@@ -207,9 +207,144 @@ define(["jquery", "./enums", "./util"], function ($, enums, util) {
         clean_monster_table();
     };
 
+    // Decoding of the binary map frames sent with the tile_binary_map
+    // option; see _pack_cell() in tileweb.cc for the format. Field names
+    // and the order of this list match binary_cell_field there.
+    var binary_fields = [
+        function (r, c) { c.f = r.uint(); },
+        function (r, c) { c.mf = r.uint(); },
+        function (r, c) { c.g = r.glyph(); },
+        function (r, c) { c.col = r.uint(); },
+        function (r, c) { c.t.fg = r.tile(); },
+        function (r, c) { c.t.base = r.uint(); },
+        function (r, c) { c.t.bg = r.tile(); },
+        function (r, c) { c.t.cloud = r.tile(); },
+        function (r, c) { c.t.bloody = !!r.uint(); },
+        function (r, c) { c.t.old_blood = !!r.uint(); },
+        function (r, c) { c.t.silenced = !!r.uint(); },
+        function (r, c) { c.t.halo = r.sint(); },
+        function (r, c) { c.t.moldy = !!r.uint(); },
+        function (r, c) { c.t.glowing_mold = !!r.uint(); },
+        function (r, c) { c.t.sanctuary = !!r.uint(); },
+        function (r, c) { c.t.liquefied = !!r.uint(); },
+        function (r, c) { c.t.orb_glow = r.sint(); },
+        function (r, c) { c.t.quad_glow = !!r.uint(); },
+        function (r, c) { c.t.disjunct = !!r.uint(); },
+        function (r, c) { c.t.mangrove_water = !!r.uint(); },
+        function (r, c) { c.t.blood_rotation = r.sint(); },
+        function (r, c) { c.t.travel_trail = r.sint(); },
+        function (r, c) { c.t.heat_aura = r.sint(); },
+        function (r, c) {
+            c.t.flv = { f: r.uint() };
+            var s = r.uint();
+            if (s)
+                c.t.flv.s = s;
+        },
+        function (r, c) {
+            var n = r.uint();
+            c.t.ov = [];
+            for (var i = 0; i < n; ++i)
+                c.t.ov.push(r.sint());
+        },
+        function (r, c) { c.mon = null; },
+        function (r, c) {
+            var n = r.uint();
+            var json = JSON.parse(decodeURIComponent(
+                escape(r.data.substr(r.pos, n))));
+            r.pos += n;
+            if ("mon" in json)
+                c.mon = json.mon;
+            if (json.t)
+                $.extend(c.t, json.t);
+        },
+    ];
+
+    function binary_reader(data)
+    {
+        var r = { data: data, pos: 0 };
+        r.uint = function ()
+        {
+            // Exact up to 2^53, which is plenty for everything but tiles.
+            var value = 0, scale = 1, b;
+            do
+            {
+                b = data.charCodeAt(r.pos++);
+                value += (b & 0x7F) * scale;
+                scale *= 128;
+            } while (b & 0x80);
+            return value;
+        };
+        r.sint = function ()
+        {
+            var v = r.uint();
+            return v % 2 ? -(v + 1) / 2 : v / 2;
+        };
+        r.tile = function ()
+        {
+            // Same representation as the JSON messages: an int if the
+            // tile index fits in 32 bits, else a [lo, hi] pair.
+            var lo = 0, hi = 0, shift = 0, b;
+            do
+            {
+                b = data.charCodeAt(r.pos++);
+                if (shift < 28)
+                    lo |= (b & 0x7F) << shift;
+                else if (shift == 28)
+                {
+                    lo |= (b & 0x0F) << 28;
+                    hi = (b & 0x7F) >> 4;
+                }
+                else
+                    hi |= (b & 0x7F) << (shift - 32);
+                shift += 7;
+            } while (b & 0x80);
+            return hi ? [lo | 0, hi | 0] : lo | 0;
+        };
+        r.glyph = function ()
+        {
+            var c = r.uint();
+            if (c < 0x10000)
+                return String.fromCharCode(c);
+            c -= 0x10000;
+            return String.fromCharCode(0xD800 + (c >> 10),
+                                       0xDC00 + (c & 0x3FF));
+        };
+        return r;
+    }
+
+    function merge_binary(bin)
+    {
+        var r = binary_reader(atob(bin));
+        var width = r.uint();
+        var ox = r.sint(), oy = r.sint();
+        var idx = -1;
+
+        while (r.pos < r.data.length)
+        {
+            idx += r.uint() + 1;
+            var fields = r.uint();
+            var cell = {
+                x: idx % width + ox,
+                y: Math.floor(idx / width) + oy,
+                t: {}
+            };
+            for (var f = 0; f < binary_fields.length; ++f)
+            {
+                if (fields & (1 << f))
+                    binary_fields[f](r, cell);
+            }
+            if ($.isEmptyObject(cell.t))
+                delete cell.t;
+            merge(cell);
+        }
+
+        clean_monster_table();
+    }
+
     return {
         get: get,
         merge: merge_diff,
+        merge_binary: merge_binary,
         clear: clear,
         touch: touch,
         visible: visible,
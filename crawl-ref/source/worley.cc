@@ -63,27 +63,65 @@ namespace worley
        is 1.0. This makes an easy natural "scale" size of the cellular features. */
 #define DENSITY_ADJUSTMENT  0.398150
 
+    /* The feature points of one cube, which depend only on the cube's
+       coordinates. Neighbouring samples mostly look at the same cubes, so
+       these are memoised in a small direct-mapped table. The positions are
+       stored already offset by the cube's coordinates, exactly as they were
+       computed inline before, so results are unchanged. */
+    struct cube_points
+    {
+        int32_t xi, yi, zi;
+        bool valid;
+        int32_t count;
+        uint32_t id[5];
+        double pos[5][3];
+    };
+
+#define CUBE_CACHE_SIZE 1024
+    static cube_points cube_cache[CUBE_CACHE_SIZE];
+
+    static const cube_points &GetCube(int32_t xi, int32_t yi, int32_t zi);
+
+    /* The 27 cubes around one integer cube, looked up as they are first
+       needed. Samples falling in the same cube test the same neighbours, so
+       a batch of them shares the lookups. A cube evicted from the memo table
+       by one of its neighbours is simply looked up again. */
+    struct cube_neighbourhood
+    {
+        int32_t xi, yi, zi;
+        const cube_points *cube[3][3][3];
+
+        void centre(const int32_t int_at[3])
+        {
+            xi = int_at[0];
+            yi = int_at[1];
+            zi = int_at[2];
+            memset(cube, 0, sizeof(cube));
+        }
+
+        const cube_points &at(int dx, int dy, int dz)
+        {
+            const cube_points *&c = cube[dx+1][dy+1][dz+1];
+            if (!c || c->xi != xi + dx || c->yi != yi + dy
+                || c->zi != zi + dz)
+            {
+                c = &GetCube(xi + dx, yi + dy, zi + dz);
+            }
+            return *c;
+        }
+    };
+
     /* the function to merge-sort a "cube" of samples into the current best-found
        list of values. */
-    static void AddSamples(int32_t xi, int32_t yi, int32_t zi, int32_t max_order,
+    static void AddSamples(const cube_points &cube, int32_t max_order,
             double at[3], double *F,
             double (*delta)[3], uint32_t *ID);
 
-    /* The main function! */
-    static void _worley(double at[3], int32_t max_order,
-            double *F, double (*delta)[3], uint32_t *ID)
+    /* Scale a sample location to make mean(F[0])==1.0, and find the
+       integer cube holding it. */
+    static void _worley_locate(const double at[3], double new_at[3],
+            int32_t int_at[3])
     {
-        double x2,y2,z2, mx2, my2, mz2;
-        double new_at[3];
-        int32_t int_at[3], i;
-
-        /* Initialize the F values to "huge" so they will be replaced by the
-           first real sample tests. Note we'll be storing and comparing the
-           SQUARED distance from the feature points to avoid lots of slow
-           sqrt() calls. We'll use sqrt() only on the final answer. */
-        for (i=0; i<max_order; i++) F[i]=DBL_MAX;
-
-        /* Make our own local copy, multiplying to make mean(F[0])==1.0  */
         new_at[0]=DENSITY_ADJUSTMENT*at[0];
         new_at[1]=DENSITY_ADJUSTMENT*at[1];
         new_at[2]=DENSITY_ADJUSTMENT*at[2];
@@ -92,6 +130,22 @@ namespace worley
         int_at[0]=LFLOOR(new_at[0]); /* The macro makes this part a lot faster */
         int_at[1]=LFLOOR(new_at[1]);
         int_at[2]=LFLOOR(new_at[2]);
+    }
+
+    /* The main function! new_at and int_at come from _worley_locate(), and
+       cubes must be centred on int_at. */
+    static void _worley(double new_at[3], const int32_t int_at[3],
+            cube_neighbourhood &cubes, int32_t max_order,
+            double *F, double (*delta)[3], uint32_t *ID)
+    {
+        double x2,y2,z2, mx2, my2, mz2;
+        int32_t i;
+
+        /* Initialize the F values to "huge" so they will be replaced by the
+           first real sample tests. Note we'll be storing and comparing the
+           SQUARED distance from the feature points to avoid lots of slow
+           sqrt() calls. We'll use sqrt() only on the final answer. */
+        for (i=0; i<max_order; i++) F[i]=DBL_MAX;
 
         /* A simple way to compute the closest neighbors would be to test all
            boundary cubes exhaustively. This is simple with code like:
@@ -107,7 +161,7 @@ namespace worley
            speed of the algorithm. */
 
         /* Test the central cube for closest point(s). */
-        AddSamples(int_at[0], int_at[1], int_at[2], max_order, new_at, F, delta, ID);
+        AddSamples(cubes.at( 0, 0, 0), max_order, new_at, F, delta, ID);
 
         /* We test if neighbor cubes are even POSSIBLE contributors by examining the
            combinations of the sum of the squared distances from the cube's lower
@@ -124,62 +178,62 @@ namespace worley
 
         /* Test 6 facing neighbors of center cube. These are closest and most
            likely to have a close feature point. */
-        if (x2<F[max_order-1])  AddSamples(int_at[0]-1, int_at[1]  , int_at[2]  ,
+        if (x2<F[max_order-1])  AddSamples(cubes.at(-1, 0, 0),
                 max_order, new_at, F, delta, ID);
-        if (y2<F[max_order-1])  AddSamples(int_at[0]  , int_at[1]-1, int_at[2]  ,
+        if (y2<F[max_order-1])  AddSamples(cubes.at( 0,-1, 0),
                 max_order, new_at, F, delta, ID);
-        if (z2<F[max_order-1])  AddSamples(int_at[0]  , int_at[1]  , int_at[2]-1,
+        if (z2<F[max_order-1])  AddSamples(cubes.at( 0, 0,-1),
                 max_order, new_at, F, delta, ID);
 
-        if (mx2<F[max_order-1]) AddSamples(int_at[0]+1, int_at[1]  , int_at[2]  ,
+        if (mx2<F[max_order-1]) AddSamples(cubes.at( 1, 0, 0),
                 max_order, new_at, F, delta, ID);
-        if (my2<F[max_order-1]) AddSamples(int_at[0]  , int_at[1]+1, int_at[2]  ,
+        if (my2<F[max_order-1]) AddSamples(cubes.at( 0, 1, 0),
                 max_order, new_at, F, delta, ID);
-        if (mz2<F[max_order-1]) AddSamples(int_at[0]  , int_at[1]  , int_at[2]+1,
+        if (mz2<F[max_order-1]) AddSamples(cubes.at( 0, 0, 1),
                 max_order, new_at, F, delta, ID);
 
         /* Test 12 "edge cube" neighbors if necessary. They're next closest. */
-        if ( x2+ y2<F[max_order-1]) AddSamples(int_at[0]-1, int_at[1]-1, int_at[2]  ,
+        if ( x2+ y2<F[max_order-1]) AddSamples(cubes.at(-1,-1, 0),
                 max_order, new_at, F, delta, ID);
-        if ( x2+ z2<F[max_order-1]) AddSamples(int_at[0]-1, int_at[1]  , int_at[2]-1,
+        if ( x2+ z2<F[max_order-1]) AddSamples(cubes.at(-1, 0,-1),
                 max_order, new_at, F, delta, ID);
-        if ( y2+ z2<F[max_order-1]) AddSamples(int_at[0]  , int_at[1]-1, int_at[2]-1,
+        if ( y2+ z2<F[max_order-1]) AddSamples(cubes.at( 0,-1,-1),
                 max_order, new_at, F, delta, ID);
-        if (mx2+my2<F[max_order-1]) AddSamples(int_at[0]+1, int_at[1]+1, int_at[2]  ,
+        if (mx2+my2<F[max_order-1]) AddSamples(cubes.at( 1, 1, 0),
                 max_order, new_at, F, delta, ID);
-        if (mx2+mz2<F[max_order-1]) AddSamples(int_at[0]+1, int_at[1]  , int_at[2]+1,
+        if (mx2+mz2<F[max_order-1]) AddSamples(cubes.at( 1, 0, 1),
                 max_order, new_at, F, delta, ID);
-        if (my2+mz2<F[max_order-1]) AddSamples(int_at[0]  , int_at[1]+1, int_at[2]+1,
+        if (my2+mz2<F[max_order-1]) AddSamples(cubes.at( 0, 1, 1),
                 max_order, new_at, F, delta, ID);
-        if ( x2+my2<F[max_order-1]) AddSamples(int_at[0]-1, int_at[1]+1, int_at[2]  ,
+        if ( x2+my2<F[max_order-1]) AddSamples(cubes.at(-1, 1, 0),
                 max_order, new_at, F, delta, ID);
-        if ( x2+mz2<F[max_order-1]) AddSamples(int_at[0]-1, int_at[1]  , int_at[2]+1,
+        if ( x2+mz2<F[max_order-1]) AddSamples(cubes.at(-1, 0, 1),
                 max_order, new_at, F, delta, ID);
-        if ( y2+mz2<F[max_order-1]) AddSamples(int_at[0]  , int_at[1]-1, int_at[2]+1,
+        if ( y2+mz2<F[max_order-1]) AddSamples(cubes.at( 0,-1, 1),
                 max_order, new_at, F, delta, ID);
-        if (mx2+ y2<F[max_order-1]) AddSamples(int_at[0]+1, int_at[1]-1, int_at[2]  ,
+        if (mx2+ y2<F[max_order-1]) AddSamples(cubes.at( 1,-1, 0),
                 max_order, new_at, F, delta, ID);
-        if (mx2+ z2<F[max_order-1]) AddSamples(int_at[0]+1, int_at[1]  , int_at[2]-1,
+        if (mx2+ z2<F[max_order-1]) AddSamples(cubes.at( 1, 0,-1),
                 max_order, new_at, F, delta, ID);
-        if (my2+ z2<F[max_order-1]) AddSamples(int_at[0]  , int_at[1]+1, int_at[2]-1,
+        if (my2+ z2<F[max_order-1]) AddSamples(cubes.at( 0, 1,-1),
                 max_order, new_at, F, delta, ID);
 
         /* Final 8 "corner" cubes */
-        if ( x2+ y2+ z2<F[max_order-1]) AddSamples(int_at[0]-1, int_at[1]-1, int_at[2]-1,
+        if ( x2+ y2+ z2<F[max_order-1]) AddSamples(cubes.at(-1,-1,-1),
                 max_order, new_at, F, delta, ID);
-        if ( x2+ y2+mz2<F[max_order-1]) AddSamples(int_at[0]-1, int_at[1]-1, int_at[2]+1,
+        if ( x2+ y2+mz2<F[max_order-1]) AddSamples(cubes.at(-1,-1, 1),
                 max_order, new_at, F, delta, ID);
-        if ( x2+my2+ z2<F[max_order-1]) AddSamples(int_at[0]-1, int_at[1]+1, int_at[2]-1,
+        if ( x2+my2+ z2<F[max_order-1]) AddSamples(cubes.at(-1, 1,-1),
                 max_order, new_at, F, delta, ID);
-        if ( x2+my2+mz2<F[max_order-1]) AddSamples(int_at[0]-1, int_at[1]+1, int_at[2]+1,
+        if ( x2+my2+mz2<F[max_order-1]) AddSamples(cubes.at(-1, 1, 1),
                 max_order, new_at, F, delta, ID);
-        if (mx2+ y2+ z2<F[max_order-1]) AddSamples(int_at[0]+1, int_at[1]-1, int_at[2]-1,
+        if (mx2+ y2+ z2<F[max_order-1]) AddSamples(cubes.at( 1,-1,-1),
                 max_order, new_at, F, delta, ID);
-        if (mx2+ y2+mz2<F[max_order-1]) AddSamples(int_at[0]+1, int_at[1]-1, int_at[2]+1,
+        if (mx2+ y2+mz2<F[max_order-1]) AddSamples(cubes.at( 1,-1, 1),
                 max_order, new_at, F, delta, ID);
-        if (mx2+my2+ z2<F[max_order-1]) AddSamples(int_at[0]+1, int_at[1]+1, int_at[2]-1,
+        if (mx2+my2+ z2<F[max_order-1]) AddSamples(cubes.at( 1, 1,-1),
                 max_order, new_at, F, delta, ID);
-        if (mx2+my2+mz2<F[max_order-1]) AddSamples(int_at[0]+1, int_at[1]+1, int_at[2]+1,
+        if (mx2+my2+mz2<F[max_order-1]) AddSamples(cubes.at( 1, 1, 1),
                 max_order, new_at, F, delta, ID);
 
         /* We're done! Convert everything to right size scale */
@@ -194,13 +248,24 @@ namespace worley
         return;
     }
 
-    static void AddSamples(int32_t xi, int32_t yi, int32_t zi, int32_t max_order,
-            double at[3], double *F,
-            double (*delta)[3], uint32_t *ID)
+    static const cube_points &GetCube(int32_t xi, int32_t yi, int32_t zi)
     {
-        double dx, dy, dz, fx, fy, fz, d2;
-        int32_t count, i, j, index;
-        uint32_t seed, this_id;
+        const uint32_t slot = ((uint32_t) xi * 73856093u
+                               ^ (uint32_t) yi * 19349663u
+                               ^ (uint32_t) zi * 83492791u)
+                              % CUBE_CACHE_SIZE;
+        cube_points &cube = cube_cache[slot];
+        if (cube.valid && cube.xi == xi && cube.yi == yi && cube.zi == zi)
+            return cube;
+
+        double fx, fy, fz;
+        int32_t j;
+        uint32_t seed;
+
+        cube.xi = xi;
+        cube.yi = yi;
+        cube.zi = zi;
+        cube.valid = true;
 
         /* Each cube has a random number seed based on the cube's ID number.
            The seed might be better if it were a nonlinear hash like Perlin uses
@@ -209,13 +274,13 @@ namespace worley
         seed=702395077*xi + 915488749*yi + 2120969693*zi;
 
         /* How many feature points are in this cube? */
-        count=Poisson_count[(seed>>24)%256]; /* 256 element lookup table. Use MSB */
+        cube.count=Poisson_count[(seed>>24)%256]; /* 256 element lookup table. Use MSB */
 
         seed=1402024253*seed+586950981; /* churn the seed with good Knuth LCG */
 
-        for (j=0; j<count; j++) /* test and insert each point into our solution */
+        for (j=0; j<cube.count; j++)
         {
-            this_id=seed;
+            cube.id[j]=seed;
             seed=1402024253*seed+586950981; /* churn */
 
             /* compute the 0..1 feature point location's XYZ */
@@ -226,10 +291,27 @@ namespace worley
             fz=(seed+0.5)*(1.0/4294967296.0);
             seed=1402024253*seed+586950981; /* churn */
 
+            cube.pos[j][0]=xi+fx;
+            cube.pos[j][1]=yi+fy;
+            cube.pos[j][2]=zi+fz;
+        }
+
+        return cube;
+    }
+
+    static void AddSamples(const cube_points &cube, int32_t max_order,
+            double at[3], double *F,
+            double (*delta)[3], uint32_t *ID)
+    {
+        double dx, dy, dz, d2;
+        int32_t i, j, index;
+
+        for (j=0; j<cube.count; j++) /* test and insert each point into our solution */
+        {
             /* delta from feature point to sample location */
-            dx=xi+fx-at[0];
-            dy=yi+fy-at[1];
-            dz=zi+fz-at[2];
+            dx=cube.pos[j][0]-at[0];
+            dy=cube.pos[j][1]-at[1];
+            dz=cube.pos[j][2]-at[2];
 
             /* Distance computation!  Lots of interesting variations are
                possible here!
@@ -271,7 +353,7 @@ cases.]
                 }
                 /* Insert the new point's information into the list. */
                 F[index]=d2;
-                ID[index]=this_id;
+                ID[index]=cube.id[j];
                 delta[index][0]=dx;
                 delta[index][1]=dy;
                 delta[index][2]=dz;
@@ -281,16 +363,27 @@ cases.]
         return;
     }
 
-    noise_datum noise(double x, double y, double z)
+    /* Sample one point, reusing cubes if they are centred on the point's
+       integer cube. */
+    static void _noise(double x, double y, double z,
+            cube_neighbourhood &cubes, bool &centred, noise_datum &datum)
     {
         double point[3] = {x,y,z};
+        double new_at[3];
+        int32_t int_at[3];
         double F[2];
         double delta[2][3];
         uint32_t id[2];
 
-        _worley(point, 2, F, delta, id);
+        _worley_locate(point, new_at, int_at);
+        if (!centred || int_at[0] != cubes.xi || int_at[1] != cubes.yi
+            || int_at[2] != cubes.zi)
+        {
+            cubes.centre(int_at);
+            centred = true;
+        }
+        _worley(new_at, int_at, cubes, 2, F, delta, id);
 
-        noise_datum datum;
         datum.distance[0] = F[0];
         datum.distance[1] = F[1];
         datum.id[0] = id[0];
@@ -298,6 +391,43 @@ cases.]
         for (int i = 0; i < 2; ++i)
             for (int j = 0; j < 3; ++j)
                 datum.pos[i][j] = delta[i][j];
+    }
+
+    static int32_t _cube_coord(double v)
+    {
+        const double scaled = DENSITY_ADJUSTMENT*v;
+        return LFLOOR(scaled);
+    }
+
+    noise_datum noise(double x, double y, double z)
+    {
+        cube_neighbourhood cubes;
+        bool centred = false;
+        noise_datum datum;
+        _noise(x, y, z, cubes, centred, datum);
         return datum;
     }
+
+    void noise(const double *x, const double *y, double z, size_t count,
+               noise_datum *out)
+    {
+        /* Visit the points cube by cube, so that all the points in a cube
+           share the feature points fetched for its neighbourhood. */
+        vector<size_t> order(count);
+        for (size_t i = 0; i < count; ++i)
+            order[i] = i;
+        if (count > 1)
+        {
+            vector<pair<int32_t, int32_t>> cube(count);
+            for (size_t i = 0; i < count; ++i)
+                cube[i] = make_pair(_cube_coord(y[i]), _cube_coord(x[i]));
+            sort(order.begin(), order.end(),
+                 [&cube](size_t a, size_t b) { return cube[a] < cube[b]; });
+        }
+
+        cube_neighbourhood cubes;
+        bool centred = false;
+        for (size_t i : order)
+            _noise(x[i], y[i], z, cubes, centred, out[i]);
+    }
 }
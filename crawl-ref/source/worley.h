@@ -69,5 +69,8 @@ struct noise_datum
 };
 
 noise_datum noise(double x, double y, double z);
+// Samples count points in the plane at height z, into out.
+void noise(const double *x, const double *y, double z, size_t count,
+           noise_datum *out);
 }
 #endif /* WORLEY_H */